@@ -0,0 +1,253 @@
+#pragma once
+
+#include <common/sanitizers.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct EpochStats {
+    // Objects handed to `Retire` so far.
+    size_t retired = 0;
+    // Retired objects destroyed so far.
+    size_t reclaimed = 0;
+    // The global epoch; it starts at 1.
+    uint64_t epoch = 0;
+};
+
+// Epoch-based reclamation. Readers wrap their accesses in an `EpochGuard`; inside it they may
+// use raw pointers to retired objects without touching any shared counter. An object retired
+// in epoch `e` is destroyed once the global epoch reaches `e + 2`: the epoch only moves forward
+// when every thread inside a guard has seen the current one, so by then no guard that could
+// have seen the object is left.
+//
+// Retired objects wait in a list owned by the retiring thread. Every `kRetireBatch` retirements
+// the thread tries to advance the epoch and destroys what has become safe, in one batch.
+// A thread that exits leaves its list to the next thread that collects; the rest is destroyed
+// at program exit.
+class EpochDomain {
+public:
+    static constexpr size_t kRetireBatch = 64;
+
+    using Destroy = void (*)(void* object);
+
+    // `object` must already be unreachable for new readers.
+    static void Retire(void* object, Destroy destroy) {
+        Domain& domain = GetDomain();
+        domain.retired.fetch_add(1, std::memory_order_relaxed);
+        // Keeps the unlinking of `object` before the epoch read; see `EpochGuard`.
+        StoreLoadFence();
+        uint64_t epoch = domain.epoch.load(std::memory_order_relaxed);
+        ThreadState& state = GetThreadState();
+        state.retired.push_back({object, destroy, epoch});
+        if (state.retired.size() >= state.next_collect) {
+            TryAdvance();
+            Collect(state.retired);
+            state.next_collect = state.retired.size() + kRetireBatch;
+        }
+    }
+
+    // Advances the epoch as far as the open guards allow and destroys what has become safe.
+    static void Reclaim() {
+        TryAdvance();
+        TryAdvance();
+        Collect(GetThreadState().retired);
+    }
+
+    // Waits for two epoch advances and destroys everything the calling thread (and exited
+    // threads) retired before. Must not be called inside an `EpochGuard`.
+    static void Synchronize() {
+        Domain& domain = GetDomain();
+        uint64_t target = domain.epoch.load(std::memory_order_acquire) + 2;
+        while (domain.epoch.load(std::memory_order_acquire) < target) {
+            if (!TryAdvance()) {
+                std::this_thread::yield();
+            }
+        }
+        Collect(GetThreadState().retired);
+    }
+
+    static EpochStats GetStats() {
+        Domain& domain = GetDomain();
+        return {domain.retired.load(std::memory_order_relaxed),
+                domain.reclaimed.load(std::memory_order_relaxed),
+                domain.epoch.load(std::memory_order_relaxed)};
+    }
+
+private:
+    friend class EpochGuard;
+
+    // `epoch` is 0 outside of a guard.
+    struct alignas(64) Record {
+        std::atomic<uint64_t> epoch = 0;
+        std::atomic<bool> taken = true;
+        Record* next = nullptr;
+    };
+
+    struct Entry {
+        void* object;
+        Destroy destroy;
+        uint64_t epoch;
+    };
+
+    // Per-thread record and retire list; the leftovers of an exiting thread go to the others.
+    struct ThreadState {
+        ThreadState() : record(AcquireRecord()) {
+        }
+        ~ThreadState() {
+            Collect(retired);
+            Domain& domain = GetDomain();
+            {
+                std::lock_guard guard(domain.orphans_mutex);
+                domain.orphans.insert(domain.orphans.end(), retired.begin(), retired.end());
+            }
+            record->taken.store(false, std::memory_order_release);
+        }
+
+        Record* record;
+        size_t depth = 0;
+        std::vector<Entry> retired;
+        size_t next_collect = kRetireBatch;
+    };
+
+    struct Domain {
+        // Records are never freed: a released one is reused by the next thread.
+        ~Domain() {
+            for (Entry& entry : orphans) {
+                entry.destroy(entry.object);
+            }
+            for (Record* record = records.load(); record != nullptr;) {
+                delete std::exchange(record, record->next);
+            }
+        }
+
+        alignas(64) std::atomic<uint64_t> epoch = 1;
+        alignas(64) std::atomic<Record*> records = nullptr;
+        std::atomic<size_t> retired = 0;
+        std::atomic<size_t> reclaimed = 0;
+        // Stands in for the fences under TSan.
+        std::atomic<uint64_t> fence = 0;
+        std::mutex orphans_mutex;
+        std::vector<Entry> orphans;
+    };
+
+    static Domain& GetDomain() {
+        static Domain domain;
+        return domain;
+    }
+
+    static ThreadState& GetThreadState() {
+        thread_local ThreadState state;
+        return state;
+    }
+
+    // Orders the stores before it with the loads after it, as seen from other threads.
+    static void StoreLoadFence() {
+#if defined(SMART_PTRS_TSAN)
+        // TSan does not model fences. Read-modify-writes of one location are totally ordered and
+        // each synchronizes with the one before, which orders the two sides the same way.
+        GetDomain().fence.fetch_add(1, std::memory_order_seq_cst);
+#else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    static Record* AcquireRecord() {
+        Domain& domain = GetDomain();
+        for (Record* record = domain.records.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            bool taken = false;
+            if (!record->taken.load(std::memory_order_relaxed) &&
+                record->taken.compare_exchange_strong(taken, true, std::memory_order_acquire)) {
+                return record;
+            }
+        }
+        Record* record = new Record;
+        record->next = domain.records.load(std::memory_order_relaxed);
+        while (!domain.records.compare_exchange_weak(record->next, record,
+                                                     std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+        }
+        return record;
+    }
+
+    // Moves the epoch forward if every thread inside a guard has seen the current one.
+    static bool TryAdvance() {
+        Domain& domain = GetDomain();
+        StoreLoadFence();
+        uint64_t epoch = domain.epoch.load(std::memory_order_relaxed);
+        for (Record* record = domain.records.load(std::memory_order_acquire); record != nullptr;
+             record = record->next) {
+            // Pairs with the release stores of `EpochGuard`: the guards seen finished happen
+            // before what follows.
+            uint64_t seen = record->epoch.load(std::memory_order_acquire);
+            if (seen != 0 && seen != epoch) {
+                return false;
+            }
+        }
+        return domain.epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+    }
+
+    // Destroys the entries of `list` (and of exited threads) retired at least two epochs ago.
+    static void Collect(std::vector<Entry>& list) {
+        Domain& domain = GetDomain();
+        {
+            std::lock_guard guard(domain.orphans_mutex);
+            list.insert(list.end(), domain.orphans.begin(), domain.orphans.end());
+            domain.orphans.clear();
+        }
+        uint64_t epoch = domain.epoch.load(std::memory_order_acquire);
+        std::vector<Entry> dead;
+        size_t kept = 0;
+        for (Entry& entry : list) {
+            if (entry.epoch + 2 <= epoch) {
+                dead.push_back(entry);
+            } else {
+                list[kept++] = entry;
+            }
+        }
+        list.resize(kept);
+        // Destructors may retire more objects into `list`.
+        for (Entry& entry : dead) {
+            entry.destroy(entry.object);
+        }
+        domain.reclaimed.fetch_add(dead.size(), std::memory_order_relaxed);
+    }
+};
+
+// Read-side critical section: objects retired after the guard was entered are not destroyed
+// until it is left. Guards nest; entering costs a store to a line of the thread's own and a
+// fence, leaving one plain store.
+class EpochGuard {
+public:
+    EpochGuard() : state_(EpochDomain::GetThreadState()) {
+        if (state_.depth++ == 0) {
+            EpochDomain::Domain& domain = EpochDomain::GetDomain();
+            // Release, like the store that leaves: `TryAdvance` may only see the next guard.
+            state_.record->epoch.store(domain.epoch.load(std::memory_order_relaxed),
+                                       std::memory_order_release);
+            // Without the fence the loads of the critical section could move before the
+            // announcement. `Retire` and `TryAdvance` fence before they read the epoch and the
+            // records, and of two fences one comes first: either this announcement is seen and
+            // holds the epoch back, or the critical section sees the unlinking of every object
+            // retired before.
+            EpochDomain::StoreLoadFence();
+        }
+    }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+    ~EpochGuard() {
+        if (--state_.depth == 0) {
+            state_.record->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+private:
+    EpochDomain::ThreadState& state_;
+};
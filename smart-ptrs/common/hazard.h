@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+struct HazardStats {
+    // Objects handed to `Retire` so far.
+    size_t retired = 0;
+    // Retired objects destroyed so far.
+    size_t reclaimed = 0;
+    // Scans of the hazard slots so far.
+    size_t scans = 0;
+};
+
+// Hazard pointers: a reader publishes the address it is about to dereference in a slot of its
+// own, and a retired object is destroyed only once no slot holds its address. Readers never
+// write to the object or to any line another reader writes to.
+//
+// Retired objects wait in a list owned by the retiring thread; the list is scanned (and
+// everything unprotected destroyed) once it holds `kRetireBatch` objects or twice the number
+// of slots, whichever is more. A thread that exits leaves what is still protected to the next
+// scan of any thread; the rest is destroyed at program exit.
+class HazardDomain {
+public:
+    static constexpr size_t kRetireBatch = 64;
+
+    using Destroy = void (*)(void* object);
+
+    // `object` must already be unreachable for new readers.
+    static void Retire(void* object, Destroy destroy) {
+        Domain& domain = GetDomain();
+        domain.retired.fetch_add(1, std::memory_order_relaxed);
+        thread_local RetiredGuard guard;
+        guard.list.push_back({object, destroy});
+        size_t threshold =
+            std::max(kRetireBatch, 2 * domain.slot_count.load(std::memory_order_relaxed));
+        if (guard.list.size() >= threshold) {
+            Scan(guard.list);
+        }
+    }
+
+    // Destroys the unprotected objects retired by the calling thread and left by exited ones.
+    static void Reclaim() {
+        if (tls_retired != nullptr) {
+            Scan(*tls_retired);
+        } else {
+            std::vector<Entry> list;
+            Scan(list);
+            GiveAway(list);
+        }
+    }
+
+    static HazardStats GetStats() {
+        Domain& domain = GetDomain();
+        return {domain.retired.load(std::memory_order_relaxed),
+                domain.reclaimed.load(std::memory_order_relaxed),
+                domain.scans.load(std::memory_order_relaxed)};
+    }
+
+private:
+    friend class HazardPointer;
+
+    struct alignas(64) Slot {
+        std::atomic<const void*> pointer = nullptr;
+        std::atomic<bool> taken = true;
+        Slot* next = nullptr;
+    };
+
+    struct Entry {
+        void* object;
+        Destroy destroy;
+    };
+
+    // Leaves the protected leftovers of an exiting thread to the others.
+    struct RetiredGuard {
+        RetiredGuard() {
+            tls_retired = &list;
+        }
+        ~RetiredGuard() {
+            Scan(list);
+            GiveAway(list);
+            tls_retired = nullptr;
+        }
+
+        std::vector<Entry> list;
+    };
+
+    struct Domain {
+        // Slots are never freed: a released one is reused by the next `HazardPointer`.
+        ~Domain() {
+            for (Entry& entry : orphans) {
+                entry.destroy(entry.object);
+            }
+            for (Slot* slot = slots.load(); slot != nullptr;) {
+                delete std::exchange(slot, slot->next);
+            }
+        }
+
+        std::atomic<Slot*> slots = nullptr;
+        std::atomic<size_t> slot_count = 0;
+        std::atomic<size_t> retired = 0;
+        std::atomic<size_t> reclaimed = 0;
+        std::atomic<size_t> scans = 0;
+        std::mutex orphans_mutex;
+        std::vector<Entry> orphans;
+    };
+
+    static Domain& GetDomain() {
+        static Domain domain;
+        return domain;
+    }
+
+    static Slot* AcquireSlot() {
+        Domain& domain = GetDomain();
+        for (Slot* slot = domain.slots.load(std::memory_order_acquire); slot != nullptr;
+             slot = slot->next) {
+            bool taken = false;
+            if (!slot->taken.load(std::memory_order_relaxed) &&
+                slot->taken.compare_exchange_strong(taken, true, std::memory_order_acquire)) {
+                return slot;
+            }
+        }
+        Slot* slot = new Slot;
+        slot->next = domain.slots.load(std::memory_order_relaxed);
+        while (!domain.slots.compare_exchange_weak(slot->next, slot, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
+        }
+        domain.slot_count.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    static void ReleaseSlot(Slot* slot) {
+        slot->pointer.store(nullptr, std::memory_order_release);
+        slot->taken.store(false, std::memory_order_release);
+    }
+
+    // The seq_cst loads of the slots pair with the seq_cst publication in `Protect`: either
+    // the scan sees the hazard, or the reader sees the object unlinked and retries.
+    static void Scan(std::vector<Entry>& list) {
+        Domain& domain = GetDomain();
+        {
+            std::lock_guard guard(domain.orphans_mutex);
+            list.insert(list.end(), domain.orphans.begin(), domain.orphans.end());
+            domain.orphans.clear();
+        }
+        if (list.empty()) {
+            return;
+        }
+        domain.scans.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<const void*> hazards;
+        for (Slot* slot = domain.slots.load(std::memory_order_acquire); slot != nullptr;
+             slot = slot->next) {
+            if (const void* pointer = slot->pointer.load(std::memory_order_seq_cst)) {
+                hazards.push_back(pointer);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        std::vector<Entry> dead;
+        auto kept = std::partition(list.begin(), list.end(), [&](const Entry& entry) {
+            return std::binary_search(hazards.begin(), hazards.end(), entry.object);
+        });
+        dead.assign(kept, list.end());
+        list.erase(kept, list.end());
+        // Destructors may retire more objects into `list`.
+        for (Entry& entry : dead) {
+            entry.destroy(entry.object);
+        }
+        domain.reclaimed.fetch_add(dead.size(), std::memory_order_relaxed);
+    }
+
+    static void GiveAway(std::vector<Entry>& list) {
+        if (list.empty()) {
+            return;
+        }
+        Domain& domain = GetDomain();
+        std::lock_guard guard(domain.orphans_mutex);
+        domain.orphans.insert(domain.orphans.end(), list.begin(), list.end());
+        list.clear();
+    }
+
+    static inline thread_local std::vector<Entry>* tls_retired = nullptr;
+};
+
+// One hazard slot, held for the lifetime of the object. Protects at most one address at a time.
+class HazardPointer {
+public:
+    HazardPointer() : slot_(HazardDomain::AcquireSlot()) {
+    }
+
+    HazardPointer(const HazardPointer&) = delete;
+    HazardPointer& operator=(const HazardPointer&) = delete;
+
+    ~HazardPointer() {
+        HazardDomain::ReleaseSlot(slot_);
+    }
+
+    // Loads `source` and keeps the loaded object from being reclaimed until the next
+    // `Protect` or `Reset`. The object must be retired only after `source` stops pointing to it.
+    template <typename T>
+    T* Protect(const std::atomic<T*>& source) {
+        T* pointer = source.load(std::memory_order_relaxed);
+        while (true) {
+            slot_->pointer.store(pointer, std::memory_order_seq_cst);
+            T* current = source.load(std::memory_order_seq_cst);
+            if (current == pointer) {
+                return pointer;
+            }
+            pointer = current;
+        }
+    }
+
+    void Reset() {
+        slot_->pointer.store(nullptr, std::memory_order_release);
+    }
+
+private:
+    HazardDomain::Slot* slot_;
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+struct ReclaimerStats {
+    // Objects handed to the reclaimer thread so far.
+    size_t submitted = 0;
+    // Objects the reclaimer thread has destroyed so far.
+    size_t reclaimed = 0;
+    // Batches handed to the reclaimer thread so far.
+    size_t batches = 0;
+    // The largest queue depth seen.
+    size_t max_depth = 0;
+
+    // Objects waiting for the reclaimer thread.
+    size_t Depth() const {
+        return submitted - reclaimed;
+    }
+};
+
+// Destroys objects on a background thread, off the thread that dropped the last reference.
+//
+// `Defer` appends to a batch owned by the calling thread; a full batch is handed to the
+// reclaimer thread in one step. A partial batch stays with its thread until `Flush`, `Drain`
+// or the thread's exit. Objects deferred from the reclaimer thread itself (drops inside
+// reclaimed destructors) are destroyed in place.
+//
+// The reclaimer is a function-local static, destroyed at exit. Objects deferred after that,
+// e.g. by the destructors of other statics, or by a thread whose batch is already gone, are
+// destroyed in place too: the reclaimer is not kept alive past the exit.
+class DeferredReclaimer {
+public:
+    static constexpr size_t kBatchSize = 64;
+
+    using Destroy = void (*)(void* object);
+
+    static void Defer(void* object, Destroy destroy) {
+        if (tls_is_reclaimer || tls_batch_gone || queue_gone.load(std::memory_order_acquire)) {
+            destroy(object);
+            return;
+        }
+        thread_local BatchGuard guard;
+        if (guard.batch == nullptr) {
+            guard.batch = GetQueue().TakeFreeBatch();
+        }
+        guard.batch->entries[guard.batch->size++] = {object, destroy};
+        if (guard.batch->size == kBatchSize) {
+            GetQueue().Submit(std::exchange(guard.batch, nullptr));
+        }
+    }
+
+    // Hands the partial batch of the calling thread to the reclaimer thread.
+    static void Flush() {
+        if (tls_batch != nullptr && *tls_batch != nullptr) {
+            Batch* batch = std::exchange(*tls_batch, nullptr);
+            if (queue_gone.load(std::memory_order_acquire)) {
+                DestroyInPlace(batch);
+            } else {
+                GetQueue().Submit(batch);
+            }
+        }
+    }
+
+    // Flushes and waits until everything submitted so far is destroyed.
+    // Must not be called from a destructor run by the reclaimer.
+    static void Drain() {
+        Flush();
+        if (!queue_gone.load(std::memory_order_acquire)) {
+            GetQueue().WaitReclaimed();
+        }
+    }
+
+    static ReclaimerStats GetStats() {
+        Queue& queue = GetQueue();
+        std::lock_guard guard(queue.mutex_);
+        return queue.stats_;
+    }
+
+private:
+    struct Entry {
+        void* object;
+        Destroy destroy;
+    };
+
+    struct Batch {
+        Entry entries[kBatchSize];
+        size_t size = 0;
+        Batch* next = nullptr;
+    };
+
+    // Submits the partial batch of an exiting thread.
+    struct BatchGuard {
+        BatchGuard() {
+            tls_batch = &batch;
+        }
+        ~BatchGuard() {
+            Flush();
+            tls_batch = nullptr;
+            tls_batch_gone = true;
+        }
+
+        Batch* batch = nullptr;
+    };
+
+    class Queue {
+    public:
+        Queue() : thread_([this] { Run(); }) {
+        }
+
+        // Reclaims everything submitted before the exit.
+        ~Queue() {
+            {
+                std::lock_guard guard(mutex_);
+                stop_ = true;
+            }
+            has_work_.notify_one();
+            thread_.join();
+            queue_gone.store(true, std::memory_order_release);
+            while (free_ != nullptr) {
+                delete std::exchange(free_, free_->next);
+            }
+        }
+
+        Batch* TakeFreeBatch() {
+            {
+                std::lock_guard guard(mutex_);
+                if (free_ != nullptr) {
+                    return std::exchange(free_, free_->next);
+                }
+            }
+            return new Batch;
+        }
+
+        void Submit(Batch* batch) {
+            batch->next = nullptr;
+            {
+                std::lock_guard guard(mutex_);
+                if (tail_ == nullptr) {
+                    head_ = batch;
+                } else {
+                    tail_->next = batch;
+                }
+                tail_ = batch;
+                stats_.submitted += batch->size;
+                ++stats_.batches;
+                stats_.max_depth = std::max(stats_.max_depth, stats_.Depth());
+            }
+            has_work_.notify_one();
+        }
+
+        void WaitReclaimed() {
+            std::unique_lock lock(mutex_);
+            size_t target = stats_.submitted;
+            reclaimed_.wait(lock, [&] { return stats_.reclaimed >= target; });
+        }
+
+        std::mutex mutex_;
+        ReclaimerStats stats_;
+
+    private:
+        void Run() {
+            tls_is_reclaimer = true;
+            std::unique_lock lock(mutex_);
+            while (true) {
+                has_work_.wait(lock, [&] { return head_ != nullptr || stop_; });
+                if (head_ == nullptr) {
+                    return;
+                }
+                Batch* batches = std::exchange(head_, nullptr);
+                tail_ = nullptr;
+                lock.unlock();
+
+                size_t reclaimed = 0;
+                Batch* done = batches;
+                for (Batch* batch = batches; batch != nullptr; batch = batch->next) {
+                    for (size_t i = 0; i < batch->size; ++i) {
+                        batch->entries[i].destroy(batch->entries[i].object);
+                    }
+                    reclaimed += batch->size;
+                    batch->size = 0;
+                    if (batch->next == nullptr) {
+                        done = batch;
+                    }
+                }
+
+                lock.lock();
+                done->next = free_;
+                free_ = batches;
+                stats_.reclaimed += reclaimed;
+                reclaimed_.notify_all();
+            }
+        }
+
+        std::condition_variable has_work_;
+        std::condition_variable reclaimed_;
+        Batch* head_ = nullptr;
+        Batch* tail_ = nullptr;
+        Batch* free_ = nullptr;
+        bool stop_ = false;
+        std::thread thread_;
+    };
+
+    // For a batch left after the queue is gone.
+    static void DestroyInPlace(Batch* batch) {
+        for (size_t i = 0; i < batch->size; ++i) {
+            batch->entries[i].destroy(batch->entries[i].object);
+        }
+        delete batch;
+    }
+
+    static Queue& GetQueue() {
+        static Queue queue;
+        return queue;
+    }
+
+    // Trivially destructible, so still readable after the queue is destroyed.
+    static inline std::atomic<bool> queue_gone = false;
+    static inline thread_local bool tls_is_reclaimer = false;
+    static inline thread_local bool tls_batch_gone = false;
+    static inline thread_local Batch** tls_batch = nullptr;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+// `SMART_PTRS_TSAN` is defined when ThreadSanitizer instruments the build. GCC announces it
+// with `__SANITIZE_THREAD__`, Clang only through `__has_feature`.
+#if defined(__SANITIZE_THREAD__)
+#define SMART_PTRS_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define SMART_PTRS_TSAN
+#endif
+#endif
@@ -0,0 +1,131 @@
+#include "intrusive.h"
+#include "object_pool.h"
+
+#include <shared-from-this/borrowed.h>
+
+#include <benchmark/benchmark.h>
+
+// Copy and destroy of a pointer to one object; with several threads, all share the object.
+
+struct PlainObject : SimpleRefCounted<PlainObject> {
+    int value = 42;
+};
+
+struct SharedObject : ThreadSafeRefCounted<SharedObject> {
+    int value = 42;
+};
+
+template <typename T>
+static void BM_CopyIntrusive(benchmark::State& state) {
+    static IntrusivePtr<T> ptr = MakeIntrusive<T>();
+    for (auto _ : state) {
+        IntrusivePtr<T> copy = ptr;
+        benchmark::DoNotOptimize(copy.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CopyIntrusive<PlainObject>);
+BENCHMARK(BM_CopyIntrusive<SharedObject>)->ThreadRange(1, 8);
+
+struct InternedObject : RefCounted<InternedObject, ImmortalAtomicCounter, DefaultDelete> {
+    int value = 42;
+};
+
+static void BM_CopyImmortalIntrusive(benchmark::State& state) {
+    // Leaked on purpose: immortal objects are never deleted.
+    static InternedObject* object = [] {
+        auto* object = new InternedObject();
+        object->MakeImmortal();
+        return object;
+    }();
+    IntrusivePtr<InternedObject> ptr(object);
+    for (auto _ : state) {
+        IntrusivePtr<InternedObject> copy = ptr;
+        benchmark::DoNotOptimize(copy.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CopyImmortalIntrusive)->ThreadRange(1, 8);
+
+static void BM_CopySharedAtomic(benchmark::State& state) {
+    static auto ptr = MakeShared<int, AtomicCounting>(42);
+    for (auto _ : state) {
+        SharedPtr<int, AtomicCounting> copy = ptr;
+        benchmark::DoNotOptimize(copy.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CopySharedAtomic)->ThreadRange(1, 8);
+
+// A call-heavy loop: every iteration passes the pointer down to a helper that only reads the
+// object. By value that is an increment and a decrement per call; borrowed, none.
+
+template <typename Ptr>
+[[gnu::noinline]] static int ReadValue(Ptr ptr) {
+    return ptr->value;
+}
+
+template <typename Param, typename Ptr>
+static void PassDown(benchmark::State& state, const Ptr& ptr) {
+    for (auto _ : state) {
+        for (int i = 0; i < 16; ++i) {
+            benchmark::DoNotOptimize(ReadValue<Param>(ptr));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+
+static void BM_PassIntrusiveByValue(benchmark::State& state) {
+    static IntrusivePtr<SharedObject> ptr = MakeIntrusive<SharedObject>();
+    PassDown<IntrusivePtr<SharedObject>>(state, ptr);
+}
+BENCHMARK(BM_PassIntrusiveByValue)->ThreadRange(1, 8);
+
+static void BM_PassIntrusiveBorrowed(benchmark::State& state) {
+    static IntrusivePtr<SharedObject> ptr = MakeIntrusive<SharedObject>();
+    PassDown<Borrowed<SharedObject>>(state, ptr);
+}
+BENCHMARK(BM_PassIntrusiveBorrowed)->ThreadRange(1, 8);
+
+struct Value {
+    int value = 42;
+};
+
+static void BM_PassSharedByValue(benchmark::State& state) {
+    static auto ptr = MakeShared<Value, AtomicCounting>();
+    PassDown<SharedPtr<Value, AtomicCounting>>(state, ptr);
+}
+BENCHMARK(BM_PassSharedByValue)->ThreadRange(1, 8);
+
+static void BM_PassSharedBorrowed(benchmark::State& state) {
+    static auto ptr = MakeShared<Value, AtomicCounting>();
+    PassDown<BorrowedShared<Value, AtomicCounting>>(state, ptr);
+}
+BENCHMARK(BM_PassSharedBorrowed)->ThreadRange(1, 8);
+
+// Acquire and drop of one object: recycled through the pool, or allocated and deleted.
+
+struct PooledObjectValue : PooledObject<PooledObjectValue> {
+    int value = 42;
+};
+
+static void BM_PoolAcquire(benchmark::State& state) {
+    static IntrusiveObjectPool<PooledObjectValue> pool(1024);
+    for (auto _ : state) {
+        auto ptr = pool.Acquire();
+        benchmark::DoNotOptimize(ptr.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PoolAcquire)->ThreadRange(1, 8);
+
+static void BM_MakeIntrusive(benchmark::State& state) {
+    for (auto _ : state) {
+        auto ptr = MakeIntrusive<SharedObject>();
+        benchmark::DoNotOptimize(ptr.Get());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MakeIntrusive)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
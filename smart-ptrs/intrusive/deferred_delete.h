@@ -0,0 +1,11 @@
+#pragma once
+
+#include <common/reclaimer.h>
+
+// Opt-in deleter for `RefCounted`: deletes on the background thread of `DeferredReclaimer`.
+struct DeferredDelete {
+    template <typename T>
+    static void Destroy(T* object) {
+        DeferredReclaimer::Defer(object, [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+};
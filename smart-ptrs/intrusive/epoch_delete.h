@@ -0,0 +1,12 @@
+#pragma once
+
+#include <common/epoch.h>
+
+// Opt-in deleter for `RefCounted`: deletes once no `EpochGuard` that could have seen the object
+// is left.
+struct EpochDelete {
+    template <typename T>
+    static void Destroy(T* object) {
+        EpochDomain::Retire(object, [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+};
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <common/sanitizers.h>
+
+#include <atomic>
+#include <cassert>
 #include <cstddef>  // for std::nullptr_t
+#include <type_traits>
 #include <utility>  // for std::exchange / std::swap
 
 class SimpleCounter {
@@ -21,6 +26,64 @@ private:
     size_t count_ = 0;
 };
 
+// Safe to share between threads: increments are relaxed, decrements release, and the one
+// that drops the last reference acquires what the other owners did before they let go.
+class AtomicCounter {
+public:
+    size_t IncRef() {
+        return count_.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    size_t DecRef() {
+#if defined(SMART_PTRS_TSAN)
+        // TSan does not model fences.
+        return count_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+#else
+        size_t count = count_.fetch_sub(1, std::memory_order_release) - 1;
+        if (count == 0) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return count;
+#endif
+    }
+    size_t RefCount() const {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+protected:
+    std::atomic<size_t> count_ = 0;
+};
+
+// `AtomicCounter` that also supports `RefCounted::MakeImmortal`. The count of an immortal
+// object is set high and never written again; anything above half of it counts as immortal,
+// so updates racing with `MakeImmortal` cannot bring it back. Every update first loads the
+// count and skips the write on an immortal object, so its line stays shared between cores;
+// mortal objects pay that load and branch, which plain `AtomicCounter` does without.
+class ImmortalAtomicCounter : public AtomicCounter {
+public:
+    size_t IncRef() {
+        if (size_t count = RefCount(); count >= kImmortalThreshold) {
+            return count;
+        }
+        return AtomicCounter::IncRef();
+    }
+    size_t DecRef() {
+        if (size_t count = RefCount(); count >= kImmortalThreshold) {
+            return count;
+        }
+        return AtomicCounter::DecRef();
+    }
+    void MakeImmortal() {
+        count_.store(kImmortalRefCount, std::memory_order_relaxed);
+    }
+    bool IsImmortal() const {
+        return RefCount() >= kImmortalThreshold;
+    }
+
+private:
+    static constexpr size_t kImmortalRefCount = size_t{1} << (sizeof(size_t) * 8 - 2);
+    static constexpr size_t kImmortalThreshold = kImmortalRefCount / 2;
+};
+
 struct DefaultDelete {
     template <typename T>
     static void Destroy(T* object) {
@@ -28,40 +91,79 @@ struct DefaultDelete {
     }
 };
 
+// With `SMART_PTRS_TRACK_BORROWS` defined, `RefCounted` also counts the live `Borrowed` views
+// of the object and asserts that none is left when it is destroyed. The count is a member, so
+// the macro must be the same in every translation unit; `NDEBUG` does not turn it on.
 template <typename Derived, typename Counter, typename Deleter>
 class RefCounted {
 public:
+    RefCounted() = default;
+
+    // References point to an object, not to its value: a copy starts with no references, and
+    // an assignment keeps those of the target.
+    RefCounted(const RefCounted&) {
+    }
+    RefCounted& operator=(const RefCounted&) {
+        return *this;
+    }
+
     // Increase reference counter.
     void IncRef() {
         counter_.IncRef();
     }
 
     // Decrease reference counter.
-    // Destroy object using Deleter when the last instance dies.
+    // Destroy object using Deleter when the last instance dies. The decision is taken by the
+    // decrement itself, so two owners dropping at once cannot both see themselves as last.
     void DecRef() {
-        if (RefCount() == 1) {
+        if (counter_.DecRef() == 0) {
+#ifdef SMART_PTRS_TRACK_BORROWS
+            assert(borrows_.load(std::memory_order_relaxed) == 0 &&
+                   "Borrowed pointer outlives the object");
+#endif
             Deleter::Destroy(static_cast<Derived*>(this));
-        } else {
-            counter_.DecRef();
         }
     }
 
-    RefCounted& operator=(const RefCounted& other) {
-        return *this;
-    }
-
     // Get current counter value (the number of strong references).
     size_t RefCount() const {
         return counter_.RefCount();
     }
 
+    // From now on references are not counted and the object is never destroyed through
+    // them: for globals and interned constants. The caller must hold a reference, or no
+    // reference may exist yet. Needs a counter that supports it, such as
+    // `ImmortalAtomicCounter`.
+    void MakeImmortal() {
+        counter_.MakeImmortal();
+    }
+    bool IsImmortal() const {
+        return counter_.IsImmortal();
+    }
+
+#ifdef SMART_PTRS_TRACK_BORROWS
+    // Bookkeeping of live `Borrowed` views.
+    void AddBorrow() const {
+        borrows_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void DropBorrow() const {
+        borrows_.fetch_sub(1, std::memory_order_relaxed);
+    }
+#endif
+
 private:
     Counter counter_;
+#ifdef SMART_PTRS_TRACK_BORROWS
+    mutable std::atomic<size_t> borrows_ = 0;
+#endif
 };
 
 template <typename Derived, typename D = DefaultDelete>
 using SimpleRefCounted = RefCounted<Derived, SimpleCounter, D>;
 
+template <typename Derived, typename D = DefaultDelete>
+using ThreadSafeRefCounted = RefCounted<Derived, AtomicCounter, D>;
+
 template <typename T>
 class IntrusivePtr {
     template <typename Y>
@@ -196,6 +298,17 @@ public:
         std::swap(object_, other.object_);
     }
 
+    // Takes over a reference the caller already owns: no `IncRef`.
+    static IntrusivePtr Adopt(T* ptr) {
+        IntrusivePtr result;
+        result.object_ = ptr;
+        return result;
+    }
+    // Gives up ownership without `DecRef`: the caller now owns the reference.
+    T* Detach() {
+        return std::exchange(object_, nullptr);
+    }
+
     // Observers
     T* Get() const {
         return object_;
@@ -231,6 +344,78 @@ private:
     }
 };
 
+template <typename T, typename = void>
+struct HasBorrowTracking : std::false_type {};
+
+template <typename T>
+struct HasBorrowTracking<T, std::void_t<decltype(std::declval<const T&>().AddBorrow())>>
+    : std::true_type {};
+
+// Non-owning view of an object held by an `IntrusivePtr`, for parameters that only use the
+// object: passing one updates no counter. `Upgrade` takes a reference when one must be kept.
+// The owners must outlive the view; with `SMART_PTRS_TRACK_BORROWS`, `RefCounted` objects
+// assert it when the last reference goes.
+template <typename T>
+class Borrowed {
+public:
+    Borrowed(std::nullptr_t) : object_(nullptr) {
+    }
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    Borrowed(const IntrusivePtr<U>& owner) : object_(owner.Get()) {
+        Track();
+    }
+
+    Borrowed(const Borrowed& other) : object_(other.object_) {
+        Track();
+    }
+    Borrowed& operator=(const Borrowed& other) {
+        Untrack();
+        object_ = other.object_;
+        Track();
+        return *this;
+    }
+
+    ~Borrowed() {
+        Untrack();
+    }
+
+    T* Get() const {
+        return object_;
+    }
+    T& operator*() const {
+        return *object_;
+    }
+    T* operator->() const {
+        return object_;
+    }
+    explicit operator bool() const {
+        return object_ != nullptr;
+    }
+
+    // A new owning pointer to the object.
+    IntrusivePtr<T> Upgrade() const {
+        return IntrusivePtr<T>(object_);
+    }
+
+private:
+    void Track() {
+        if constexpr (HasBorrowTracking<T>::value) {
+            if (object_ != nullptr) {
+                object_->AddBorrow();
+            }
+        }
+    }
+    void Untrack() {
+        if constexpr (HasBorrowTracking<T>::value) {
+            if (object_ != nullptr) {
+                object_->DropBorrow();
+            }
+        }
+    }
+
+    T* object_;
+};
+
 template <typename T, typename... Args>
 IntrusivePtr<T> MakeIntrusive(Args&&... args) {
     return IntrusivePtr(new T(std::forward<Args>(args)...));
@@ -0,0 +1,278 @@
+#pragma once
+
+#include "intrusive.h"
+
+#include <common/epoch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class IntrusiveObjectPool;
+
+// Hands an object whose last reference is gone back to its pool.
+struct ReturnToPool {
+    template <typename T>
+    static void Destroy(T* object) {
+        object->home_->Recycle(object);
+    }
+};
+
+// Base of objects handed out by `IntrusiveObjectPool<Derived>`. Reference counting is atomic.
+// A `void OnReturnToPool()` member of `Derived`, if any, is called when the object comes back.
+template <typename Derived>
+class PooledObject : public RefCounted<Derived, AtomicCounter, ReturnToPool> {
+private:
+    friend struct ReturnToPool;
+    friend class IntrusiveObjectPool<Derived>;
+
+    IntrusiveObjectPool<Derived>* home_ = nullptr;
+    std::atomic<Derived*> next_free_ = nullptr;
+};
+
+template <typename T, typename = void>
+struct HasReturnHook : std::false_type {};
+
+template <typename T>
+struct HasReturnHook<T, std::void_t<decltype(std::declval<T&>().OnReturnToPool())>>
+    : std::true_type {};
+
+// Recycles objects instead of deleting them. Once enough objects exist, `Acquire` and the drop
+// of the last reference allocate nothing.
+//
+// Idle objects stay in a small cache of the thread that released them; a full cache moves half
+// of itself to a lock-free global freelist in one step, and an empty one takes objects from it.
+// The freelist keeps at most `capacity` objects; the rest are deleted. `Trim` deletes idle
+// objects on demand. Deletion goes through `EpochDomain`, so a thread popping the freelist
+// never reads a deleted object.
+//
+// All objects must be back in the pool before it is destroyed.
+template <typename T>
+class IntrusiveObjectPool {
+public:
+    static constexpr size_t kCacheSize = 32;
+
+    explicit IntrusiveObjectPool(size_t capacity) : capacity_(capacity) {
+        static_assert(std::is_base_of_v<PooledObject<T>, T>, "Unsupported type");
+    }
+
+    IntrusiveObjectPool(const IntrusiveObjectPool&) = delete;
+    IntrusiveObjectPool& operator=(const IntrusiveObjectPool&) = delete;
+
+    ~IntrusiveObjectPool() {
+        {
+            std::lock_guard guard(RegistryMutex());
+            for (ThreadCache* cache : caches_) {
+                for (size_t i = 0; i < cache->size; ++i) {
+                    delete cache->objects[i];
+                }
+                cache->size = 0;
+                cache->pool.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        T* object = PointerOf(head_.load(std::memory_order_acquire));
+        while (object != nullptr) {
+            delete std::exchange(object, object->next_free_.load(std::memory_order_relaxed));
+        }
+    }
+
+    // A recycled object if there is one, otherwise a new `T()`.
+    IntrusivePtr<T> Acquire() {
+        T* object = nullptr;
+        if (ThreadCache* cache = LocalCache(); cache->size != 0) {
+            object = cache->objects[--cache->size];
+        } else if (object = Pop(); object == nullptr) {
+            object = new T();
+            object->home_ = this;
+            created_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return IntrusivePtr<T>(object);
+    }
+
+    // Creates objects until the freelist holds `count` (or `capacity`) of them.
+    void Reserve(size_t count) {
+        count = std::min(count, capacity_);
+        while (idle_.load(std::memory_order_relaxed) < count) {
+            T* object = new T();
+            object->home_ = this;
+            created_.fetch_add(1, std::memory_order_relaxed);
+            object->next_free_.store(nullptr, std::memory_order_relaxed);
+            PushChain(object, object, 1);
+        }
+    }
+
+    // Deletes idle objects from the freelist until at most `keep` are left there.
+    void Trim(size_t keep = 0) {
+        while (idle_.load(std::memory_order_relaxed) > keep) {
+            T* object = Pop();
+            if (object == nullptr) {
+                break;
+            }
+            Retire(object);
+        }
+    }
+
+    // Objects on the freelist; objects in thread caches are not counted.
+    size_t IdleCount() const {
+        return idle_.load(std::memory_order_relaxed);
+    }
+    // Objects created so far.
+    size_t CreatedCount() const {
+        return created_.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend struct ReturnToPool;
+
+    struct ThreadCache {
+        // Reset by the pool's destructor.
+        std::atomic<IntrusiveObjectPool*> pool;
+        T* objects[kCacheSize];
+        size_t size = 0;
+    };
+
+    // The caches of one thread, one per pool it used; handed back when the thread exits.
+    struct ThreadCaches {
+        ~ThreadCaches() {
+            tls_exited = true;
+            std::lock_guard guard(RegistryMutex());
+            for (auto& cache : caches) {
+                IntrusiveObjectPool* pool = cache->pool.load(std::memory_order_relaxed);
+                if (pool == nullptr) {
+                    continue;
+                }
+                // The epoch state of this thread may be gone already: nothing is deleted here.
+                if (cache->size != 0) {
+                    pool->PushAll(cache->objects, cache->size);
+                }
+                auto& registered = pool->caches_;
+                registered.erase(std::find(registered.begin(), registered.end(), cache.get()));
+            }
+        }
+
+        std::vector<std::unique_ptr<ThreadCache>> caches;
+    };
+
+    static constexpr int kTagShift = 48;
+    static constexpr uint64_t kOneTag = uint64_t{1} << kTagShift;
+    static constexpr uint64_t kAddressMask = kOneTag - 1;
+
+    static T* PointerOf(uint64_t word) {
+        return reinterpret_cast<T*>(word & kAddressMask);
+    }
+    // The head word pointing to `object`, with the tag of `head` bumped.
+    static uint64_t NextHead(uint64_t head, T* object) {
+        return ((head & ~kAddressMask) + kOneTag) | reinterpret_cast<uintptr_t>(object);
+    }
+
+    static std::mutex& RegistryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    ThreadCache* LocalCache() {
+        for (auto& cache : tls_caches.caches) {
+            if (cache->pool.load(std::memory_order_relaxed) == this) {
+                return cache.get();
+            }
+        }
+        std::lock_guard guard(RegistryMutex());
+        auto& caches = tls_caches.caches;
+        caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                    [](const auto& cache) {
+                                        return cache->pool.load(std::memory_order_relaxed) ==
+                                               nullptr;
+                                    }),
+                     caches.end());
+        auto& cache = caches.emplace_back(new ThreadCache{{this}, {}, 0});
+        caches_.push_back(cache.get());
+        return cache.get();
+    }
+
+    void Recycle(T* object) {
+        if constexpr (HasReturnHook<T>::value) {
+            object->OnReturnToPool();
+        }
+        if (tls_exited) {
+            PushAll(&object, 1);
+            return;
+        }
+        ThreadCache* cache = LocalCache();
+        if (cache->size == kCacheSize) {
+            cache->size -= kCacheSize / 2;
+            PushObjects(cache->objects + cache->size, kCacheSize / 2);
+        }
+        cache->objects[cache->size++] = object;
+    }
+
+    // Links `objects` into one chain and pushes it with a single CAS; what does not fit under
+    // the capacity is deleted.
+    void PushObjects(T** objects, size_t count) {
+        size_t idle = idle_.load(std::memory_order_relaxed);
+        size_t kept = idle >= capacity_ ? 0 : std::min(count, capacity_ - idle);
+        for (size_t i = kept; i < count; ++i) {
+            Retire(objects[i]);
+        }
+        if (kept != 0) {
+            PushAll(objects, kept);
+        }
+    }
+
+    void PushAll(T** objects, size_t count) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            objects[i]->next_free_.store(objects[i + 1], std::memory_order_relaxed);
+        }
+        PushChain(objects[0], objects[count - 1], count);
+    }
+
+    void PushChain(T* first, T* last, size_t count) {
+        assert((reinterpret_cast<uintptr_t>(first) & ~kAddressMask) == 0);
+        idle_.fetch_add(count, std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        while (true) {
+            last->next_free_.store(PointerOf(head), std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, NextHead(head, first), std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    // The tag in the high bits makes a stale head fail the CAS; the epoch guard keeps the
+    // object read through it from being deleted meanwhile.
+    T* Pop() {
+        EpochGuard guard;
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (T* object = PointerOf(head)) {
+            T* next = object->next_free_.load(std::memory_order_relaxed);
+            if (head_.compare_exchange_weak(head, NextHead(head, next), std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+                idle_.fetch_sub(1, std::memory_order_relaxed);
+                return object;
+            }
+        }
+        return nullptr;
+    }
+
+    static void Retire(T* object) {
+        EpochDomain::Retire(object, [](void* ptr) { delete static_cast<T*>(ptr); });
+    }
+
+    const size_t capacity_;
+    alignas(64) std::atomic<uint64_t> head_ = 0;
+    std::atomic<size_t> idle_ = 0;
+    std::atomic<size_t> created_ = 0;
+    // Caches of live threads that used this pool; guarded by `RegistryMutex`.
+    std::vector<ThreadCache*> caches_;
+
+    static inline thread_local ThreadCaches tls_caches;
+    static inline thread_local bool tls_exited = false;
+};
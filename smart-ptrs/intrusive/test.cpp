@@ -1,10 +1,17 @@
 #include "intrusive.h"
+#include "deferred_delete.h"
+#include "epoch_delete.h"
+#include "object_pool.h"
 
 #include <catch.hpp>
 
 #include "allocations_checker.h"
 
+#include <array>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -386,3 +393,383 @@ TEST_CASE("Object pool") {
         REQUIRE(strs.NumInUse() == 1);
     }
 }
+
+struct Deferred : public SimpleRefCounted<Deferred, DeferredDelete> {
+    ~Deferred() {
+        destroyed_on = std::this_thread::get_id();
+        destroyed.fetch_add(1);
+    }
+
+    static inline std::atomic<int> destroyed = 0;
+    static inline std::thread::id destroyed_on;
+};
+
+TEST_CASE("Deferred delete") {
+    auto before = DeferredReclaimer::GetStats();
+    {
+        auto a = MakeIntrusive<Deferred>();
+        auto b = a;
+    }
+    DeferredReclaimer::Drain();
+    REQUIRE(Deferred::destroyed.load() == 1);
+    REQUIRE(Deferred::destroyed_on != std::this_thread::get_id());
+
+    auto after = DeferredReclaimer::GetStats();
+    REQUIRE(after.submitted - before.submitted == 1);
+    REQUIRE(after.Depth() == 0);
+}
+
+struct EpochManaged : public SimpleRefCounted<EpochManaged, EpochDelete> {
+    ~EpochManaged() {
+        destroyed.fetch_add(1);
+    }
+
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("Epoch delete") {
+    auto a = MakeIntrusive<EpochManaged>();
+    EpochManaged* raw = a.Get();
+    {
+        EpochGuard guard;
+        a.Reset();
+        EpochDomain::Reclaim();
+        REQUIRE(EpochManaged::destroyed.load() == 0);
+        REQUIRE(raw->RefCount() == 0);
+    }
+    EpochDomain::Synchronize();
+    REQUIRE(EpochManaged::destroyed.load() == 1);
+}
+
+struct Shared : public ThreadSafeRefCounted<Shared> {
+    explicit Shared(int threads) : touched(threads, 0) {
+    }
+    ~Shared() {
+        int sum = 0;
+        for (int value : touched) {
+            sum += value;
+        }
+        total.store(sum);
+        destroyed.fetch_add(1);
+    }
+
+    // Plain writes by every owner, read by the destructor on whichever thread drops last.
+    std::vector<int> touched;
+    static inline std::atomic<int> total = 0;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("Thread-safe reference counting") {
+    constexpr int kThreads = 8;
+    constexpr int kRounds = 200;
+    constexpr int kCopies = 100;
+
+    for (int round = 0; round < kRounds; ++round) {
+        auto shared = MakeIntrusive<Shared>(kThreads);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.emplace_back([i, owned = shared]() mutable {
+                for (int j = 0; j < kCopies; ++j) {
+                    auto copy = owned;
+                    IntrusivePtr<Shared> moved(std::move(copy));
+                }
+                owned->touched[i] = 1;
+                owned.Reset();
+            });
+        }
+        shared.Reset();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(Shared::destroyed.load() == round + 1);
+        REQUIRE(Shared::total.load() == kThreads);
+    }
+}
+
+struct Tally : ThreadSafeRefCounted<Tally> {
+    explicit Tally(int value) : value(value) {
+    }
+
+    int value;
+};
+
+TEST_CASE("Copying counted objects") {
+    auto a = MakeIntrusive<Tally>(1);
+    auto b = MakeIntrusive<Tally>(2);
+    auto also_b = b;
+
+    Tally copy = *b;
+    REQUIRE(copy.value == 2);
+    REQUIRE(copy.RefCount() == 0);
+
+    *a = *b;
+    REQUIRE(a->value == 2);
+    REQUIRE(a->RefCount() == 1);
+    REQUIRE(b->RefCount() == 2);
+
+    *b = copy;
+    REQUIRE(b->RefCount() == 2);
+}
+
+TEST_CASE("Adopt and detach") {
+    auto a = MakeIntrusive<MyInt>(5);
+    MyInt* raw = a.Detach();
+    REQUIRE(a.Get() == nullptr);
+    REQUIRE(raw->RefCount() == 1);
+
+    auto b = IntrusivePtr<MyInt>::Adopt(raw);
+    REQUIRE(b.UseCount() == 1);
+    REQUIRE(b->value == 5);
+
+    IntrusivePtr<MyInt> empty;
+    REQUIRE(empty.Detach() == nullptr);
+    REQUIRE(IntrusivePtr<MyInt>::Adopt(nullptr).Get() == nullptr);
+}
+
+static int SumBorrowed(Borrowed<MyInt> first, Borrowed<MyInt> second) {
+    return first->value + (second ? second->value : 0);
+}
+
+// The test target defines `SMART_PTRS_TRACK_BORROWS`.
+static_assert(HasBorrowTracking<MyInt>::value);
+
+TEST_CASE("Borrowed") {
+    auto a = MakeIntrusive<MyInt>(3);
+    auto b = MakeIntrusive<MyInt>(4);
+
+    SECTION("No reference counting") {
+        REQUIRE(SumBorrowed(a, b) == 7);
+        REQUIRE(SumBorrowed(a, nullptr) == 3);
+        Borrowed<MyInt> view = a;
+        Borrowed<MyInt> copy = view;
+        copy = b;
+        REQUIRE(view.Get() == a.Get());
+        REQUIRE((*copy).value == 4);
+        REQUIRE(a.UseCount() == 1);
+        REQUIRE(b.UseCount() == 1);
+        EXPECT_ZERO_ALLOCATIONS(REQUIRE(SumBorrowed(a, b) == 7));
+    }
+
+    SECTION("Upgrade") {
+        IntrusivePtr<MyInt> owner;
+        {
+            Borrowed<MyInt> view = a;
+            owner = view.Upgrade();
+            REQUIRE(a.UseCount() == 2);
+        }
+        a.Reset();
+        REQUIRE(owner->value == 3);
+        REQUIRE(owner.UseCount() == 1);
+        REQUIRE(!Borrowed<MyInt>(nullptr).Upgrade());
+    }
+}
+
+struct Interned : RefCounted<Interned, ImmortalAtomicCounter, DefaultDelete> {
+    ~Interned() {
+        destroyed.fetch_add(1);
+    }
+
+    int value = 42;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("Immortal objects") {
+    SECTION("Mortal until made immortal") {
+        int destroyed = Interned::destroyed.load();
+        auto first = MakeIntrusive<Interned>();
+        auto copy = first;
+        REQUIRE(first.UseCount() == 2);
+        REQUIRE(!first->IsImmortal());
+        first.Reset();
+        copy.Reset();
+        REQUIRE(Interned::destroyed.load() == destroyed + 1);
+
+        // Leaked on purpose: immortal objects are never deleted.
+        static auto* object = new Interned();
+        IntrusivePtr<Interned> held(object);
+        object->MakeImmortal();
+        REQUIRE(object->IsImmortal());
+        size_t count = held.UseCount();
+        {
+            auto again = held;
+            IntrusivePtr<Interned> other(object);
+            REQUIRE(held.UseCount() == count);
+        }
+        held.Reset();
+        REQUIRE(object->RefCount() == count);
+        REQUIRE(Interned::destroyed.load() == destroyed + 1);
+    }
+
+    SECTION("Shared between threads") {
+        constexpr int kThreads = 8;
+        constexpr int kCopies = 10000;
+        int destroyed = Interned::destroyed.load();
+        static auto* object = new Interned();
+        object->MakeImmortal();
+        IntrusivePtr<Interned> global(object);
+        size_t count = global.UseCount();
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.emplace_back([&global] {
+                for (int j = 0; j < kCopies; ++j) {
+                    auto copy = global;
+                    IntrusivePtr<Interned> moved(std::move(copy));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        global.Reset();
+        REQUIRE(object->RefCount() == count);
+        REQUIRE(Interned::destroyed.load() == destroyed);
+    }
+}
+
+struct Pooled : PooledObject<Pooled> {
+    ~Pooled() {
+        destroyed.fetch_add(1);
+    }
+    void OnReturnToPool() {
+        value = 0;
+        ++returns;
+    }
+
+    int value = 0;
+    int returns = 0;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+struct PooledNoHook : PooledObject<PooledNoHook> {
+    int value = 0;
+};
+
+TEST_CASE("Intrusive object pool") {
+    SECTION("Reuse") {
+        IntrusiveObjectPool<Pooled> pool(16);
+        auto a = pool.Acquire();
+        Pooled* raw = a.Get();
+        a->value = 42;
+        REQUIRE(a->RefCount() == 1);
+        a.Reset();
+        EXPECT_ZERO_ALLOCATIONS(a = pool.Acquire());
+        REQUIRE(a.Get() == raw);
+        REQUIRE(a->value == 0);
+        REQUIRE(a->returns == 1);
+        REQUIRE(a->RefCount() == 1);
+        REQUIRE(pool.CreatedCount() == 1);
+    }
+
+    SECTION("No hook") {
+        IntrusiveObjectPool<PooledNoHook> pool(16);
+        auto a = pool.Acquire();
+        a->value = 42;
+        PooledNoHook* raw = a.Get();
+        a.Reset();
+        a = pool.Acquire();
+        REQUIRE(a.Get() == raw);
+        REQUIRE(a->value == 42);
+    }
+
+    SECTION("Capacity and trimming") {
+        constexpr int kObjects = 100;
+        int destroyed = Pooled::destroyed.load();
+        {
+            IntrusiveObjectPool<Pooled> pool(8);
+            pool.Reserve(20);
+            REQUIRE(pool.IdleCount() == 8);
+            std::vector<IntrusivePtr<Pooled>> held;
+            for (int i = 0; i < kObjects; ++i) {
+                held.push_back(pool.Acquire());
+            }
+            REQUIRE(pool.CreatedCount() == kObjects);
+            held.clear();
+            REQUIRE(pool.IdleCount() == 8);
+            pool.Trim(2);
+            REQUIRE(pool.IdleCount() == 2);
+            pool.Trim();
+            REQUIRE(pool.IdleCount() == 0);
+        }
+        EpochDomain::Synchronize();
+        REQUIRE(Pooled::destroyed.load() - destroyed == kObjects);
+    }
+
+    SECTION("Objects released by an exiting thread") {
+        IntrusiveObjectPool<Pooled> pool(64);
+        auto a = pool.Acquire();
+        std::thread([&pool, owned = std::move(a)]() mutable {
+            auto b = pool.Acquire();
+            owned.Reset();
+        }).join();
+        REQUIRE(pool.IdleCount() == 2);
+        auto b = pool.Acquire();
+        auto c = pool.Acquire();
+        REQUIRE(pool.CreatedCount() == 2);
+    }
+}
+
+TEST_CASE("Intrusive object pool under many threads") {
+    constexpr int kThreads = 8;
+    constexpr int kHeld = 48;
+    constexpr int kRounds = 500;
+
+    IntrusiveObjectPool<Pooled> pool(4096);
+    std::atomic<int> holding = 0;
+    std::atomic<int> warmed = 0;
+    std::atomic<bool> go = false;
+    std::atomic<int> done = 0;
+    std::atomic<int> dirty = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i] {
+            std::array<IntrusivePtr<Pooled>, kHeld> held;
+            // Warm-up: every thread holds its share at the same time.
+            for (auto& ptr : held) {
+                ptr = pool.Acquire();
+            }
+            holding.fetch_add(1);
+            while (holding.load() < kThreads) {
+                std::this_thread::yield();
+            }
+            for (auto& ptr : held) {
+                ptr.Reset();
+            }
+            warmed.fetch_add(1);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+
+            for (int round = 0; round < kRounds; ++round) {
+                for (auto& ptr : held) {
+                    ptr = pool.Acquire();
+                    if (ptr->value != 0) {
+                        dirty.fetch_add(1);
+                    }
+                    ptr->value = i + 1;
+                }
+                for (auto& ptr : held) {
+                    ptr.Reset();
+                }
+            }
+            done.fetch_add(1);
+        });
+    }
+
+    while (warmed.load() < kThreads) {
+        std::this_thread::yield();
+    }
+    // Covers the objects in flight between a cache and the freelist.
+    pool.Reserve(pool.IdleCount() + kThreads * IntrusiveObjectPool<Pooled>::kCacheSize / 2);
+    size_t created = pool.CreatedCount();
+
+    EXPECT_ZERO_ALLOCATIONS(go.store(true); while (done.load() < kThreads) {
+        std::this_thread::yield();
+    });
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(pool.CreatedCount() == created);
+    REQUIRE(dirty.load() == 0);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "shared.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+// Lock-free holder of a `SharedPtr<T, AtomicCounting>` for publishing values across threads.
+//
+// A stored value is moved into a publication block (a `MakeShared` block holding the value),
+// and the holder prepays that block with `kBatch` strong references. The atomic word keeps
+// the block address in its low 48 bits and, in the high 16 bits, how many of the prepaid
+// references readers have already taken. `Load` is a single `fetch_add` on the word and does
+// not touch the block's counter, except for a refill once per `kRefill` loads.
+//
+// Loaded pointers share ownership of the publication block, not of the stored value's block.
+// Compared with the stored value:
+// - `UseCount` counts the publication block, prepaid references included;
+// - a `WeakPtr` made from a loaded pointer expires once the publication block dies (the value
+//   is replaced and every loaded pointer is gone), even if the object lives on elsewhere;
+// - `GetDeleter` returns nullptr;
+// - ownership is not shared: only `CompareExchange` treats both as equivalent.
+// Copy the stored value out of `Exchange` when the original ownership is needed.
+//
+// Block addresses must fit in 48 bits; storing a value throws `std::overflow_error` otherwise.
+template <typename T>
+class AtomicSharedPtr {
+public:
+    using Value = SharedPtr<T, AtomicCounting>;
+
+    AtomicSharedPtr() = default;
+
+    AtomicSharedPtr(Value value) : word_(Publish(std::move(value))) {
+    }
+
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+    ~AtomicSharedPtr() {
+        TakeOne(word_.load(std::memory_order_acquire));
+    }
+
+    Value Load() const {
+        uint64_t word = word_.fetch_add(kOneReader, std::memory_order_acquire);
+        Block* block = BlockOf(word);
+        if (block == nullptr) {
+            return Value();
+        }
+        if (ReadersOf(word) + 1 >= kRefill) {
+            Refill(block);
+        }
+        return Value(block, block->GetObject()->Get());
+    }
+
+    void Store(Value desired) {
+        TakeOne(word_.exchange(Publish(std::move(desired)), std::memory_order_acq_rel));
+    }
+
+    Value Exchange(Value desired) {
+        return TakeOne(word_.exchange(Publish(std::move(desired)), std::memory_order_acq_rel));
+    }
+
+    // Replaces the value with `desired` if it is equivalent to `expected`: the same pointer
+    // sharing ownership either with the stored value or with a value loaded from here.
+    // Otherwise loads the current value into `expected`.
+    bool CompareExchange(Value& expected, Value desired) {
+        Value current = Load();
+        uint64_t published = 0;
+        bool is_published = false;
+        while (Equivalent(current, expected)) {
+            uint64_t word = word_.load(std::memory_order_relaxed);
+            while (BlockOf(word) == current.block_) {
+                if (!is_published) {
+                    published = Publish(std::move(desired));
+                    is_published = true;
+                }
+                if (word_.compare_exchange_weak(word, published, std::memory_order_acq_rel,
+                                                std::memory_order_relaxed)) {
+                    TakeOne(word);
+                    return true;
+                }
+            }
+            current = Load();
+        }
+        if (is_published) {
+            TakeOne(published);
+        }
+        expected = std::move(current);
+        return false;
+    }
+
+    bool IsLockFree() const {
+        return word_.is_lock_free();
+    }
+
+private:
+    using Block = ControlBlockForNewObject<Value, AtomicCounting>;
+
+    static constexpr int kReaderShift = 48;
+    static constexpr uint64_t kOneReader = uint64_t{1} << kReaderShift;
+    static constexpr uint64_t kAddressMask = kOneReader - 1;
+    // Readers never take more than 2^16 - 1 references, so the holder always keeps one.
+    static constexpr int kBatch = 1 << 16;
+    static constexpr int kRefill = kBatch / 2;
+
+    static Block* BlockOf(uint64_t word) {
+        return reinterpret_cast<Block*>(word & kAddressMask);
+    }
+    static int ReadersOf(uint64_t word) {
+        return static_cast<int>(word >> kReaderShift);
+    }
+
+    static uint64_t Publish(Value value) {
+        if (!value) {
+            return 0;
+        }
+        Block* block = AllocateControlBlock<Block>(std::allocator<Value>(),
+                                                   std::allocator<Value>(), std::move(value));
+        uint64_t word = reinterpret_cast<uintptr_t>(block);
+        if ((word & ~kAddressMask) != 0) {
+            // The tag would overwrite the address. Drop the block with its only reference.
+            Value(block, block->GetObject()->Get()).Reset();
+            throw std::overflow_error("AtomicSharedPtr: block address wider than 48 bits");
+        }
+        block->GetCounting().TransferStrong(kBatch - 1);
+        return word;
+    }
+
+    // Turns the references prepaid for an unpublished word into one owned pointer.
+    static Value TakeOne(uint64_t word) {
+        Block* block = BlockOf(word);
+        if (block == nullptr) {
+            return Value();
+        }
+        block->GetCounting().TransferStrong(-(kBatch - ReadersOf(word) - 1));
+        return Value(block, block->GetObject()->Get());
+    }
+
+    // Prepays `kRefill` more references and takes them off the readers' count,
+    // unless the block has been replaced or another reader refilled first.
+    void Refill(Block* block) const {
+        block->GetCounting().TransferStrong(kRefill);
+        uint64_t word = word_.load(std::memory_order_relaxed);
+        while (BlockOf(word) == block && ReadersOf(word) >= kRefill) {
+            if (word_.compare_exchange_weak(word, word - kRefill * kOneReader,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        block->GetCounting().TransferStrong(-kRefill);
+    }
+
+    static bool Equivalent(const Value& current, const Value& expected) {
+        if (current.block_ == expected.block_ && current.pointer_ == expected.pointer_) {
+            return true;
+        }
+        if (!current) {
+            return false;
+        }
+        const Value& stored = *static_cast<Block*>(current.block_)->GetObject();
+        return stored.block_ == expected.block_ && stored.pointer_ == expected.pointer_;
+    }
+
+    mutable std::atomic<uint64_t> word_ = 0;
+};
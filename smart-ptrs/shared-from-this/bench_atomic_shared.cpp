@@ -0,0 +1,52 @@
+#include "atomic_shared.h"
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+
+// One writer per 1024 reads; every thread reads and the first one also writes.
+constexpr int kStorePeriod = 1024;
+
+static void BM_LoadAtomicSharedPtr(benchmark::State& state) {
+    static AtomicSharedPtr<int> atomic;
+    if (state.thread_index() == 0) {
+        atomic.Store(MakeShared<int, AtomicCounting>(0));
+    }
+    int iteration = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++iteration % kStorePeriod == 0) {
+            atomic.Store(MakeShared<int, AtomicCounting>(iteration));
+        }
+        auto value = atomic.Load();
+        benchmark::DoNotOptimize(*value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadAtomicSharedPtr)->ThreadRange(1, 8);
+
+static void BM_LoadMutexSharedPtr(benchmark::State& state) {
+    static std::mutex mutex;
+    static SharedPtr<int, AtomicCounting> shared;
+    if (state.thread_index() == 0) {
+        std::lock_guard guard(mutex);
+        shared = MakeShared<int, AtomicCounting>(0);
+    }
+    int iteration = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++iteration % kStorePeriod == 0) {
+            auto fresh = MakeShared<int, AtomicCounting>(iteration);
+            std::lock_guard guard(mutex);
+            shared.Swap(fresh);
+        }
+        SharedPtr<int, AtomicCounting> value;
+        {
+            std::lock_guard guard(mutex);
+            value = shared;
+        }
+        benchmark::DoNotOptimize(*value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LoadMutexSharedPtr)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+#include "buffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+// A message passes through `kStages` stages; each strips an 8-byte header and hands the rest
+// on, either as a slice of the same allocation or as a fresh copy.
+constexpr int kStages = 4;
+constexpr size_t kHeader = 8;
+
+static void BM_PassSlices(benchmark::State& state) {
+    size_t size = state.range(0);
+    auto message = SharedBuffer<AtomicCounting>::Allocate(
+        size, [size](std::byte* data) { std::memset(data, 1, size); });
+    for (auto _ : state) {
+        SharedBuffer<AtomicCounting> stage = message;
+        for (int i = 0; i < kStages; ++i) {
+            stage = std::move(stage).Slice(kHeader, stage.Size() - kHeader);
+        }
+        benchmark::DoNotOptimize(stage.Data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_PassSlices)->RangeMultiplier(8)->Range(512, 1 << 20);
+
+static void BM_PassCopies(benchmark::State& state) {
+    size_t size = state.range(0);
+    std::vector<std::byte> message(size, std::byte{1});
+    for (auto _ : state) {
+        std::vector<std::byte> stage = message;
+        for (int i = 0; i < kStages; ++i) {
+            stage = std::vector<std::byte>(stage.begin() + kHeader, stage.end());
+        }
+        benchmark::DoNotOptimize(stage.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_PassCopies)->RangeMultiplier(8)->Range(512, 1 << 20);
+
+BENCHMARK_MAIN();
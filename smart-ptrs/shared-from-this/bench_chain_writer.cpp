@@ -0,0 +1,75 @@
+#include "chain_writer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+// A response of `state.range(0)` fragments: a small header per 4 KiB body chunk, written to
+// an unlinked temporary file. Either the fragments go to `writev` as they are, or they are
+// copied into one buffer that goes to `write`.
+constexpr size_t kHeader = 32;
+constexpr size_t kChunk = 4096;
+
+static int OpenTempFile() {
+    char path[] = "/tmp/smart-ptrs-bench-XXXXXX";
+    int fd = mkstemp(path);
+    unlink(path);
+    return fd;
+}
+
+static BufferChain<> MakeResponse(const SharedBuffer<>& body, int64_t fragments) {
+    static auto header = SharedBuffer<>::Allocate(
+        kHeader, [](std::byte* data) { std::fill_n(data, kHeader, std::byte{'h'}); });
+    BufferChain<> chain;
+    for (int64_t i = 0; i < fragments / 2; ++i) {
+        chain.Append(header);
+        chain.Append(body.Slice(i * kChunk % (body.Size() - kChunk), kChunk));
+    }
+    return chain;
+}
+
+static SharedBuffer<> MakeBody() {
+    return SharedBuffer<>::Allocate(
+        1 << 20, [](std::byte* data) { std::fill_n(data, 1 << 20, std::byte{'b'}); });
+}
+
+static void BM_WritevChain(benchmark::State& state) {
+    int fd = OpenTempFile();
+    auto body = MakeBody();
+    size_t size = MakeResponse(body, state.range(0)).Size();
+    for (auto _ : state) {
+        auto chain = MakeResponse(body, state.range(0));
+        lseek(fd, 0, SEEK_SET);
+        benchmark::DoNotOptimize(WriteChain(fd, chain));
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+    close(fd);
+}
+BENCHMARK(BM_WritevChain)->Arg(16)->Arg(64)->Arg(256);
+
+static void BM_CopyThenWrite(benchmark::State& state) {
+    int fd = OpenTempFile();
+    auto body = MakeBody();
+    std::vector<std::byte> flat;
+    size_t size = MakeResponse(body, state.range(0)).Size();
+    for (auto _ : state) {
+        auto chain = MakeResponse(body, state.range(0));
+        flat.resize(chain.Size());
+        chain.CopyTo(flat.data());
+        lseek(fd, 0, SEEK_SET);
+        size_t done = 0;
+        while (done < flat.size()) {
+            done += write(fd, flat.data() + done, flat.size() - done);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+    close(fd);
+}
+BENCHMARK(BM_CopyThenWrite)->Arg(16)->Arg(64)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,140 @@
+#include "shared.h"
+#include "slab.h"
+#include "weak.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+template <typename Counting>
+static void BM_CopyDestroy(benchmark::State& state) {
+    auto ptr = MakeShared<int, Counting>(42);
+    for (auto _ : state) {
+        SharedPtr<int, Counting> copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_CopyDestroy<SingleThreadedCounting>);
+BENCHMARK(BM_CopyDestroy<AtomicCounting>);
+
+template <typename Counting>
+static void BM_WeakCopyDestroy(benchmark::State& state) {
+    auto ptr = MakeShared<int, Counting>(42);
+    WeakPtr<int, Counting> weak = ptr;
+    for (auto _ : state) {
+        WeakPtr<int, Counting> copy = weak;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_WeakCopyDestroy<SingleThreadedCounting>);
+BENCHMARK(BM_WeakCopyDestroy<AtomicCounting>);
+
+// Copies and destroys pointers whose control blocks are of different dynamic types,
+// so the compiler cannot resolve the block type at the call site.
+template <typename Counting>
+[[gnu::noinline]] static void CopyAll(const std::vector<SharedPtr<int, Counting>>& source,
+                                      std::vector<SharedPtr<int, Counting>>& copies) {
+    for (const auto& ptr : source) {
+        copies.push_back(ptr);
+    }
+    copies.clear();
+}
+
+template <typename Counting>
+static void BM_CopyMixedBlocks(benchmark::State& state) {
+    std::vector<SharedPtr<int, Counting>> source;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        if (i % 2 == 0) {
+            source.push_back(MakeShared<int, Counting>(i));
+        } else {
+            source.emplace_back(new int(i));
+        }
+    }
+    std::vector<SharedPtr<int, Counting>> copies;
+    copies.reserve(source.size());
+    for (auto _ : state) {
+        CopyAll(source, copies);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CopyMixedBlocks<SingleThreadedCounting>)->Arg(1024);
+BENCHMARK(BM_CopyMixedBlocks<AtomicCounting>)->Arg(1024);
+
+template <typename Counting>
+static void BM_MakeSharedDestroy(benchmark::State& state) {
+    for (auto _ : state) {
+        auto ptr = MakeShared<int, Counting>(42);
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(BM_MakeSharedDestroy<SingleThreadedCounting>);
+BENCHMARK(BM_MakeSharedDestroy<AtomicCounting>);
+
+BENCHMARK(BM_MakeSharedDestroy<SlabAllocated<SingleThreadedCounting>>);
+
+// The object is allocated outside of the loop, so only the control block is measured.
+template <typename Counting>
+static void BM_AdoptDestroy(benchmark::State& state) {
+    struct NoDelete {
+        void operator()(int*) const {
+        }
+    };
+    int value = 42;
+    for (auto _ : state) {
+        SharedPtr<int, Counting> ptr(&value, NoDelete(), DefaultBlockAllocator<Counting, int>());
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(BM_AdoptDestroy<SingleThreadedCounting>);
+BENCHMARK(BM_AdoptDestroy<SlabAllocated<SingleThreadedCounting>>);
+BENCHMARK(BM_AdoptDestroy<AtomicCounting>);
+BENCHMARK(BM_AdoptDestroy<SlabAllocated<AtomicCounting>>);
+
+// Adopting with the default deleter, an empty custom one and a one-word custom one: all are
+// kept inside the block, so the cost should not differ.
+struct EmptyDelete {
+    void operator()(int* ptr) const {
+        delete ptr;
+    }
+};
+
+struct CountingDelete {
+    int64_t* deleted;
+    void operator()(int* ptr) const {
+        ++*deleted;
+        delete ptr;
+    }
+};
+
+template <typename Counting>
+static void BM_AdoptDefaultDeleter(benchmark::State& state) {
+    for (auto _ : state) {
+        SharedPtr<int, Counting> ptr(new int(42));
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(BM_AdoptDefaultDeleter<SingleThreadedCounting>);
+BENCHMARK(BM_AdoptDefaultDeleter<AtomicCounting>);
+
+template <typename Counting>
+static void BM_AdoptEmptyDeleter(benchmark::State& state) {
+    for (auto _ : state) {
+        SharedPtr<int, Counting> ptr(new int(42), EmptyDelete());
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(BM_AdoptEmptyDeleter<SingleThreadedCounting>);
+BENCHMARK(BM_AdoptEmptyDeleter<AtomicCounting>);
+
+template <typename Counting>
+static void BM_AdoptStatefulDeleter(benchmark::State& state) {
+    int64_t deleted = 0;
+    for (auto _ : state) {
+        SharedPtr<int, Counting> ptr(new int(42), CountingDelete{&deleted});
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+BENCHMARK(BM_AdoptStatefulDeleter<SingleThreadedCounting>);
+BENCHMARK(BM_AdoptStatefulDeleter<AtomicCounting>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#include "shared.h"
+#include "weak.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+// Every thread copies and destroys its own pointer: the uncontended cost of a count update.
+template <typename Ptr, typename Make>
+static void CopyPrivate(benchmark::State& state, Make make) {
+    Ptr ptr = make();
+    for (auto _ : state) {
+        Ptr copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+// All threads copy and destroy the same pointer: the counter cache line is contended.
+template <typename Ptr>
+static void CopyShared(benchmark::State& state, const Ptr& ptr) {
+    for (auto _ : state) {
+        Ptr copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+static void BM_CopyPrivateSingleThreaded(benchmark::State& state) {
+    CopyPrivate<SharedPtr<int, SingleThreadedCounting>>(
+        state, [] { return MakeShared<int, SingleThreadedCounting>(42); });
+}
+BENCHMARK(BM_CopyPrivateSingleThreaded)->ThreadRange(1, 8);
+
+static void BM_CopyPrivateAtomic(benchmark::State& state) {
+    CopyPrivate<SharedPtr<int, AtomicCounting>>(
+        state, [] { return MakeShared<int, AtomicCounting>(42); });
+}
+BENCHMARK(BM_CopyPrivateAtomic)->ThreadRange(1, 8);
+
+// Copies on the thread that created the object: the owner's plain counter.
+static void BM_CopyPrivateBiased(benchmark::State& state) {
+    CopyPrivate<SharedPtr<int, BiasedCounting>>(
+        state, [] { return MakeShared<int, BiasedCounting>(42); });
+}
+BENCHMARK(BM_CopyPrivateBiased)->ThreadRange(1, 8);
+
+static void BM_CopyPrivateStd(benchmark::State& state) {
+    CopyPrivate<std::shared_ptr<int>>(state, [] { return std::make_shared<int>(42); });
+}
+BENCHMARK(BM_CopyPrivateStd)->ThreadRange(1, 8);
+
+static const auto kSharedAtomic = MakeShared<int, AtomicCounting>(42);
+static const auto kSharedStd = std::make_shared<int>(42);
+
+static void BM_CopySharedAtomic(benchmark::State& state) {
+    CopyShared(state, kSharedAtomic);
+}
+BENCHMARK(BM_CopySharedAtomic)->ThreadRange(1, 8);
+
+// Created on the main thread: benchmark threads other than the first one are not owners.
+static const auto kSharedBiased = MakeShared<int, BiasedCounting>(42);
+
+static void BM_CopySharedBiased(benchmark::State& state) {
+    CopyShared(state, kSharedBiased);
+}
+BENCHMARK(BM_CopySharedBiased)->ThreadRange(1, 8);
+
+static void BM_CopySharedStd(benchmark::State& state) {
+    CopyShared(state, kSharedStd);
+}
+BENCHMARK(BM_CopySharedStd)->ThreadRange(1, 8);
+
+// Weak-keyed cache lookups: every thread locks the same weak pointer.
+static void BM_WeakLockAtomic(benchmark::State& state) {
+    static const WeakPtr<int, AtomicCounting> weak = kSharedAtomic;
+    for (auto _ : state) {
+        auto locked = weak.Lock();
+        benchmark::DoNotOptimize(locked);
+    }
+}
+BENCHMARK(BM_WeakLockAtomic)->ThreadRange(1, 8);
+
+static void BM_WeakLockStd(benchmark::State& state) {
+    static const std::weak_ptr<int> weak = kSharedStd;
+    for (auto _ : state) {
+        auto locked = weak.lock();
+        benchmark::DoNotOptimize(locked);
+    }
+}
+BENCHMARK(BM_WeakLockStd)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
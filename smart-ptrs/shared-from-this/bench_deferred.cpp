@@ -0,0 +1,53 @@
+#include "deferred.h"
+#include "shared.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+struct Graph {
+    std::vector<std::string> nodes;
+};
+
+static Graph* MakeGraph(int64_t size) {
+    auto graph = new Graph;
+    for (int64_t i = 0; i < size; ++i) {
+        graph->nodes.emplace_back(64, 'x');
+    }
+    return graph;
+}
+
+// The latency of dropping the last reference on the request thread.
+template <typename Counting>
+static void DropLast(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        SharedPtr<Graph, Counting> graph(MakeGraph(state.range(0)));
+        state.ResumeTiming();
+        graph.Reset();
+        state.PauseTiming();
+        DeferredReclaimer::Drain();
+        state.ResumeTiming();
+    }
+}
+
+static void BM_DropLastInline(benchmark::State& state) {
+    DropLast<AtomicCounting>(state);
+}
+BENCHMARK(BM_DropLastInline)
+    ->Arg(100)
+    ->Arg(10'000)
+    ->Iterations(500)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_DropLastDeferred(benchmark::State& state) {
+    DropLast<DeferredDestruction<AtomicCounting>>(state);
+}
+BENCHMARK(BM_DropLastDeferred)
+    ->Arg(100)
+    ->Arg(10'000)
+    ->Iterations(500)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
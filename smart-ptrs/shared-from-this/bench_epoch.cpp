@@ -0,0 +1,94 @@
+#include "atomic_shared.h"
+#include "epoch_destruction.h"
+#include "hazard_shared.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <atomic>
+
+// Read-mostly map: a fixed set of keys whose values are replaced now and then. Every thread
+// looks keys up; the first one also replaces a value once per `kStorePeriod` lookups.
+constexpr size_t kKeys = 1024;
+constexpr int kStorePeriod = 1024;
+
+struct Value {
+    int64_t payload;
+};
+
+static size_t NextKey(size_t key) {
+    return (key * 7 + 1) % kKeys;
+}
+
+static void BM_MapAtomicSharedPtr(benchmark::State& state) {
+    static std::array<AtomicSharedPtr<Value>, kKeys> map;
+    if (state.thread_index() == 0) {
+        for (auto& slot : map) {
+            slot.Store(MakeShared<Value, AtomicCounting>(Value{0}));
+        }
+    }
+    size_t key = state.thread_index();
+    int iteration = 0;
+    for (auto _ : state) {
+        key = NextKey(key);
+        if (state.thread_index() == 0 && ++iteration % kStorePeriod == 0) {
+            map[key].Store(MakeShared<Value, AtomicCounting>(Value{iteration}));
+        }
+        auto value = map[key].Load();
+        benchmark::DoNotOptimize(value->payload);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapAtomicSharedPtr)->ThreadRange(1, 64)->UseRealTime();
+
+static void BM_MapHazard(benchmark::State& state) {
+    static std::array<HazardSharedPtr<Value>, kKeys> map;
+    if (state.thread_index() == 0) {
+        for (auto& slot : map) {
+            slot.Store(MakeThinShared<Value, AtomicCounting>(Value{0}));
+        }
+    }
+    HazardPointer hazard;
+    size_t key = state.thread_index();
+    int iteration = 0;
+    for (auto _ : state) {
+        key = NextKey(key);
+        if (state.thread_index() == 0 && ++iteration % kStorePeriod == 0) {
+            map[key].Store(MakeThinShared<Value, AtomicCounting>(Value{iteration}));
+        }
+        benchmark::DoNotOptimize(map[key].Protect(hazard)->payload);
+    }
+    hazard.Reset();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapHazard)->ThreadRange(1, 64)->UseRealTime();
+
+using EpochValue = SharedPtr<Value, EpochDestruction<AtomicCounting>>;
+
+// The writer owns the values; readers copy raw pointers out under an `EpochGuard`.
+static void BM_MapEpoch(benchmark::State& state) {
+    static std::array<EpochValue, kKeys> owners;
+    static std::array<std::atomic<Value*>, kKeys> map;
+    if (state.thread_index() == 0) {
+        for (size_t i = 0; i < kKeys; ++i) {
+            owners[i] = MakeShared<Value, EpochDestruction<AtomicCounting>>(Value{0});
+            map[i].store(owners[i].Get(), std::memory_order_release);
+        }
+    }
+    size_t key = state.thread_index();
+    int iteration = 0;
+    for (auto _ : state) {
+        key = NextKey(key);
+        if (state.thread_index() == 0 && ++iteration % kStorePeriod == 0) {
+            auto fresh = MakeShared<Value, EpochDestruction<AtomicCounting>>(Value{iteration});
+            map[key].store(fresh.Get(), std::memory_order_release);
+            owners[key] = std::move(fresh);
+        }
+        EpochGuard guard;
+        benchmark::DoNotOptimize(map[key].load(std::memory_order_acquire)->payload);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MapEpoch)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+#include "atomic_shared.h"
+#include "hazard_shared.h"
+#include "weak.h"
+
+#include <benchmark/benchmark.h>
+
+// Read-side throughput of a published object: every thread only reads.
+constexpr int kReaders = 64;
+
+static void BM_ReadWeakLock(benchmark::State& state) {
+    static auto shared = MakeShared<int, AtomicCounting>(1);
+    static WeakPtr<int, AtomicCounting> weak = shared;
+    for (auto _ : state) {
+        auto value = weak.Lock();
+        benchmark::DoNotOptimize(*value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadWeakLock)->ThreadRange(1, kReaders)->UseRealTime();
+
+static void BM_ReadAtomicSharedPtr(benchmark::State& state) {
+    static AtomicSharedPtr<int> atomic(MakeShared<int, AtomicCounting>(1));
+    for (auto _ : state) {
+        auto value = atomic.Load();
+        benchmark::DoNotOptimize(*value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadAtomicSharedPtr)->ThreadRange(1, kReaders)->UseRealTime();
+
+static void BM_ReadHazardProtect(benchmark::State& state) {
+    static HazardSharedPtr<int> cell(MakeThinShared<int, AtomicCounting>(1));
+    HazardPointer hazard;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(*cell.Protect(hazard));
+    }
+    hazard.Reset();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadHazardProtect)->ThreadRange(1, kReaders)->UseRealTime();
+
+BENCHMARK_MAIN();
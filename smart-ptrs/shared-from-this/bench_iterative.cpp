@@ -0,0 +1,43 @@
+#include "iterative.h"
+#include "shared.h"
+
+#include <benchmark/benchmark.h>
+
+template <typename Counting>
+struct Node {
+    explicit Node(SharedPtr<Node, Counting> next) : next(std::move(next)) {
+    }
+    SharedPtr<Node, Counting> next;
+};
+
+// Only the release of the whole list is timed.
+template <typename Counting>
+static void DestroyList(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        SharedPtr<Node<Counting>, Counting> head;
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            head = MakeShared<Node<Counting>, Counting>(std::move(head));
+        }
+        state.ResumeTiming();
+        head.Reset();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Recursive release: longer lists overflow the default stack.
+static void BM_DestroyListRecursive(benchmark::State& state) {
+    DestroyList<SingleThreadedCounting>(state);
+}
+BENCHMARK(BM_DestroyListRecursive)->Arg(10'000)->Unit(benchmark::kMillisecond);
+
+static void BM_DestroyListIterative(benchmark::State& state) {
+    DestroyList<IterativeDestruction<SingleThreadedCounting>>(state);
+}
+BENCHMARK(BM_DestroyListIterative)
+    ->Arg(10'000)
+    ->Arg(10'000'000)
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include "rcu_cell.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+// A configuration snapshot read on every request and reloaded now and then: every thread
+// reads, the first one also reloads once per `kReloadPeriod` reads.
+constexpr int kReloadPeriod = 4096;
+
+struct Config {
+    int64_t version = 0;
+    std::map<std::string, int> limits = {{"connections", 100}, {"requests", 1000}};
+};
+
+static void BM_ReadRcuCell(benchmark::State& state) {
+    static RcuCell<Config> cell;
+    int iteration = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++iteration % kReloadPeriod == 0) {
+            cell.Update([](Config& config) { ++config.version; });
+        }
+        auto config = cell.Read();
+        benchmark::DoNotOptimize(config->version);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadRcuCell)->ThreadRange(1, 64)->UseRealTime();
+
+// The hand-rolled reload: a mutex around a shared pointer that readers copy.
+static void BM_ReadMutexSharedPtr(benchmark::State& state) {
+    static std::mutex mutex;
+    static SharedPtr<const Config, AtomicCounting> shared = MakeShared<Config, AtomicCounting>();
+    int iteration = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++iteration % kReloadPeriod == 0) {
+            SharedPtr<const Config, AtomicCounting> current;
+            {
+                std::lock_guard guard(mutex);
+                current = shared;
+            }
+            auto fresh = MakeShared<Config, AtomicCounting>(*current);
+            ++fresh->version;
+            std::lock_guard guard(mutex);
+            shared = fresh;
+        }
+        SharedPtr<const Config, AtomicCounting> config;
+        {
+            std::lock_guard guard(mutex);
+            config = shared;
+        }
+        benchmark::DoNotOptimize(config->version);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ReadMutexSharedPtr)->ThreadRange(1, 64)->UseRealTime();
+
+BENCHMARK_MAIN();
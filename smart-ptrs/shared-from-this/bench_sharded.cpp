@@ -0,0 +1,39 @@
+#include "immortal.h"
+#include "sharded.h"
+
+#include <benchmark/benchmark.h>
+
+// Every thread copies and destroys pointers to one hot global object.
+template <typename Ptr>
+static void CopyHot(benchmark::State& state, const Ptr& ptr) {
+    for (auto _ : state) {
+        Ptr copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static const auto kHotAtomic = MakeShared<int, AtomicCounting>(42);
+static const auto kHotSharded = MakeShardedShared<int>(42);
+
+static void BM_CopyHotAtomic(benchmark::State& state) {
+    CopyHot(state, kHotAtomic);
+}
+BENCHMARK(BM_CopyHotAtomic)->ThreadRange(1, 32)->UseRealTime();
+
+static void BM_CopyHotSharded(benchmark::State& state) {
+    // Each thread copies its own handle: updates go to the thread's slot.
+    auto handle = kHotSharded.Share();
+    CopyHot(state, handle);
+}
+BENCHMARK(BM_CopyHotSharded)->ThreadRange(1, 32)->UseRealTime();
+
+static constinit ImmortalShared<int> kHotObject(42);
+static constinit SharedPtr<int, ImmortalAtomicCounting> kHotImmortal(kHotObject);
+
+static void BM_CopyHotImmortal(benchmark::State& state) {
+    CopyHot(state, kHotImmortal);
+}
+BENCHMARK(BM_CopyHotImmortal)->ThreadRange(1, 32)->UseRealTime();
+
+BENCHMARK_MAIN();
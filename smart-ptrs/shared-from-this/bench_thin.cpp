@@ -0,0 +1,35 @@
+#include "thin.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+// Scanning a large index of pointers: thin pointers halve the bytes streamed.
+template <typename Ptr, typename Make>
+static void ScanIndex(benchmark::State& state, Make make) {
+    std::vector<Ptr> index;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        index.push_back(make(static_cast<int>(i)));
+    }
+    for (auto _ : state) {
+        int64_t non_null = 0;
+        for (const Ptr& ptr : index) {
+            non_null += static_cast<bool>(ptr);
+        }
+        benchmark::DoNotOptimize(non_null);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(Ptr));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ScanShared(benchmark::State& state) {
+    ScanIndex<SharedPtr<int>>(state, [](int i) { return MakeShared<int>(i); });
+}
+BENCHMARK(BM_ScanShared)->Arg(1 << 20);
+
+static void BM_ScanThin(benchmark::State& state) {
+    ScanIndex<ThinSharedPtr<int>>(state, [](int i) { return MakeThinShared<int>(i); });
+}
+BENCHMARK(BM_ScanThin)->Arg(1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "shared.h"
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+// Non-owning view of an object held by a `SharedPtr`, for parameters that only use the object:
+// passing one updates no counter, where a `SharedPtr` by value costs an increment and a
+// decrement. `Upgrade` takes a strong reference when one must be kept.
+// The owners must outlive the view. With `SMART_PTRS_TRACK_BORROWS` defined it is checked: the
+// view holds a weak reference, so the block stays readable, and every access asserts the object
+// still has an owner. Views pass weak references between translation units, so the macro must
+// be the same in all of them; `NDEBUG` does not turn it on.
+template <typename T, typename Counting>
+class BorrowedShared {
+public:
+    using ElementType = std::remove_extent_t<T>;
+
+    BorrowedShared(std::nullptr_t) : pointer_(nullptr), block_(nullptr) {
+    }
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    BorrowedShared(const SharedPtr<U, Counting>& owner)
+        : pointer_(owner.pointer_), block_(owner.block_) {
+        Track();
+    }
+
+    BorrowedShared(const BorrowedShared& other) : pointer_(other.pointer_), block_(other.block_) {
+        Track();
+    }
+    BorrowedShared& operator=(const BorrowedShared& other) {
+        if (this == &other) {
+            return *this;
+        }
+        Untrack();
+        pointer_ = other.pointer_;
+        block_ = other.block_;
+        Track();
+        return *this;
+    }
+
+    ~BorrowedShared() {
+        Untrack();
+    }
+
+    ElementType* Get() const {
+        CheckOwned();
+        return pointer_;
+    }
+    ElementType& operator*() const {
+        static_assert(!std::is_array_v<T>);
+        return *Get();
+    }
+    ElementType* operator->() const {
+        static_assert(!std::is_array_v<T>);
+        return Get();
+    }
+    explicit operator bool() const {
+        return block_ != nullptr;
+    }
+
+    // A new owning pointer to the object.
+    SharedPtr<T, Counting> Upgrade() const {
+        CheckOwned();
+        if (block_ != nullptr) {
+            block_->GetCounting().IncStrong();
+        }
+        return SharedPtr<T, Counting>::Adopt({pointer_, block_});
+    }
+
+private:
+    void Track() {
+#ifdef SMART_PTRS_TRACK_BORROWS
+        if (block_ != nullptr) {
+            block_->GetCounting().IncWeak();
+        }
+#endif
+    }
+    void Untrack() {
+#ifdef SMART_PTRS_TRACK_BORROWS
+        if (block_ != nullptr) {
+            block_->ReleaseWeak();
+        }
+#endif
+    }
+    void CheckOwned() const {
+#ifdef SMART_PTRS_TRACK_BORROWS
+        assert((block_ == nullptr || block_->GetCounting().StrongCount() != 0) &&
+               "Borrowed pointer outlives the object");
+#endif
+    }
+
+    ElementType* pointer_;
+    ControlBlock<Counting>* block_;
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "shared.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+// A view of bytes in a shared allocation. Slicing and splitting make new views that share
+// ownership of the allocation (through the aliasing constructor) without copying a byte.
+// The bytes are read-only: `Allocate` writes them before the buffer exists, and a buffer may
+// view memory that cannot be written at all, such as a read-only mapping.
+template <typename Counting = SingleThreadedCounting>
+class SharedBuffer {
+public:
+    using Storage = SharedPtr<const std::byte[], Counting>;
+
+    SharedBuffer() = default;
+
+    // Views the first `size` bytes of `storage`.
+    SharedBuffer(Storage storage, size_t size) : data_(std::move(storage)), size_(size) {
+    }
+
+    SharedBuffer(const SharedBuffer&) = default;
+    SharedBuffer(SharedBuffer&& other)
+        : data_(std::move(other.data_)), size_(std::exchange(other.size_, 0)) {
+    }
+
+    SharedBuffer& operator=(const SharedBuffer&) = default;
+    SharedBuffer& operator=(SharedBuffer&& other) {
+        data_ = std::move(other.data_);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    // `size` new bytes, written by `fill(std::byte* data)` before anyone else can see them.
+    template <typename Fill>
+    static SharedBuffer Allocate(size_t size, Fill&& fill) {
+        auto storage = MakeSharedForOverwrite<std::byte[], Counting>(size);
+        fill(storage.Get());
+        return SharedBuffer(std::move(storage), size);
+    }
+
+    static SharedBuffer CopyFrom(const void* data, size_t size) {
+        return Allocate(size, [&](std::byte* out) {
+            if (size != 0) {
+                std::memcpy(out, data, size);
+            }
+        });
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Views
+
+    // Bytes [offset, offset + size) of this view.
+    SharedBuffer Slice(size_t offset, size_t size) const& {
+        assert(offset + size <= size_);
+        return SharedBuffer(Storage(data_, data_.Get() + offset), size);
+    }
+    SharedBuffer Slice(size_t offset, size_t size) && {
+        assert(offset + size <= size_);
+        const std::byte* data = data_.Get() + offset;
+        size_ = 0;
+        return SharedBuffer(Storage(std::move(data_), data), size);
+    }
+
+    // Keeps the first `offset` bytes and returns the rest.
+    SharedBuffer Split(size_t offset) {
+        assert(offset <= size_);
+        SharedBuffer tail = Slice(offset, size_ - offset);
+        size_ = offset;
+        return tail;
+    }
+
+    void RemovePrefix(size_t size) {
+        assert(size <= size_);
+        const std::byte* data = data_.Get() + size;
+        data_ = Storage(std::move(data_), data);
+        size_ -= size;
+    }
+    void RemoveSuffix(size_t size) {
+        assert(size <= size_);
+        size_ -= size;
+    }
+
+    void Reset() {
+        data_.Reset();
+        size_ = 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    const std::byte* Data() const {
+        return data_.Get();
+    }
+    size_t Size() const {
+        return size_;
+    }
+    bool Empty() const {
+        return size_ == 0;
+    }
+    std::byte operator[](size_t index) const {
+        return data_[index];
+    }
+    // The bytes as an array of `T`, sharing ownership. The view must be aligned for `T`.
+    template <typename T>
+    SharedPtr<const T[], Counting> ViewAs() const {
+        assert(reinterpret_cast<uintptr_t>(Data()) % alignof(T) == 0);
+        return SharedPtr<const T[], Counting>(data_, reinterpret_cast<const T*>(Data()));
+    }
+    // The number of views (and other owners) sharing the allocation.
+    size_t UseCount() const {
+        return data_.UseCount();
+    }
+
+private:
+    Storage data_;
+    size_t size_ = 0;
+};
+
+// A message made of buffers, e.g. a header and payload fragments from different reads.
+// Splitting and trimming move or slice fragments; bytes are copied only by `Flatten`
+// and `CopyTo`.
+template <typename Counting = SingleThreadedCounting>
+class BufferChain {
+public:
+    using Buffer = SharedBuffer<Counting>;
+    using Iterator = typename std::deque<Buffer>::const_iterator;
+
+    BufferChain() = default;
+
+    BufferChain(Buffer buffer) {
+        Append(std::move(buffer));
+    }
+
+    void Append(Buffer buffer) {
+        if (!buffer.Empty()) {
+            size_ += buffer.Size();
+            fragments_.push_back(std::move(buffer));
+        }
+    }
+    void Append(BufferChain chain) {
+        for (Buffer& buffer : chain.fragments_) {
+            Append(std::move(buffer));
+        }
+    }
+
+    // Removes the first `size` bytes and returns them as a chain of their own.
+    BufferChain Split(size_t size) {
+        assert(size <= size_);
+        BufferChain head;
+        while (size != 0) {
+            Buffer& front = fragments_.front();
+            if (front.Size() <= size) {
+                size -= front.Size();
+                head.Append(PopFront());
+            } else {
+                head.Append(front.Slice(0, size));
+                front.RemovePrefix(size);
+                size_ -= size;
+                size = 0;
+            }
+        }
+        return head;
+    }
+
+    void RemovePrefix(size_t size) {
+        assert(size <= size_);
+        while (size != 0) {
+            Buffer& front = fragments_.front();
+            if (front.Size() <= size) {
+                size -= front.Size();
+                PopFront();
+            } else {
+                front.RemovePrefix(size);
+                size_ -= size;
+                size = 0;
+            }
+        }
+    }
+
+    // Copies the bytes to `out`, which must have room for `Size()` of them.
+    void CopyTo(std::byte* out) const {
+        for (const Buffer& buffer : fragments_) {
+            std::memcpy(out, buffer.Data(), buffer.Size());
+            out += buffer.Size();
+        }
+    }
+
+    // One contiguous buffer; a chain of one fragment is shared, not copied.
+    Buffer Flatten() const {
+        if (fragments_.size() == 1) {
+            return fragments_.front();
+        }
+        return Buffer::Allocate(size_, [this](std::byte* out) { CopyTo(out); });
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+    bool Empty() const {
+        return size_ == 0;
+    }
+    size_t FragmentCount() const {
+        return fragments_.size();
+    }
+    Iterator begin() const {
+        return fragments_.begin();
+    }
+    Iterator end() const {
+        return fragments_.end();
+    }
+
+private:
+    Buffer PopFront() {
+        Buffer front = std::move(fragments_.front());
+        fragments_.pop_front();
+        size_ -= front.Size();
+        return front;
+    }
+
+    std::deque<Buffer> fragments_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "buffer.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Scatter/gather output of a `BufferChain`: the fragments go to the kernel as one `iovec`
+// array instead of being copied into a contiguous buffer first. The chain keeps owning every
+// fragment until it has been written; written bytes are dropped from its front.
+
+// Describes up to `max` leading fragments of `chain` in `iov`; returns how many.
+template <typename Counting>
+size_t FillIovec(const BufferChain<Counting>& chain, iovec* iov, size_t max) {
+    size_t count = 0;
+    for (const auto& fragment : chain) {
+        if (count == max) {
+            break;
+        }
+        iov[count].iov_base = const_cast<std::byte*>(fragment.Data());
+        iov[count].iov_len = fragment.Size();
+        ++count;
+    }
+    return count;
+}
+
+// Hands at most this many fragments to one system call.
+inline constexpr size_t kIovecBatch = 64;
+
+// Calls `write(iov, count)` until `chain` is empty or the descriptor would block or takes
+// nothing. `call` names the system call in errors.
+template <typename Counting, typename Write>
+size_t WriteGathered(BufferChain<Counting>& chain, const char* call, Write write) {
+    size_t total = 0;
+    iovec iov[kIovecBatch];
+    while (!chain.Empty()) {
+        size_t count = FillIovec(chain, iov, kIovecBatch);
+        ssize_t written = write(iov, static_cast<int>(count));
+        if (written == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            throw std::system_error(errno, std::generic_category(), call);
+        }
+        if (written == 0) {
+            break;
+        }
+        chain.RemovePrefix(written);
+        total += written;
+    }
+    return total;
+}
+
+// Writes `chain` to `fd` with `writev`. On a non-blocking descriptor that would block, or if
+// the descriptor takes no bytes, returns early and leaves the rest in `chain`. Returns the number of bytes written; throws
+// `std::system_error` on other errors.
+template <typename Counting>
+size_t WriteChain(int fd, BufferChain<Counting>& chain) {
+    return WriteGathered(chain, "writev", [fd](iovec* iov, int count) {
+        return writev(fd, iov, count);
+    });
+}
+
+// Same as `WriteChain` for sockets, through `sendmsg` with `flags`.
+template <typename Counting>
+size_t SendChain(int fd, BufferChain<Counting>& chain, int flags = MSG_NOSIGNAL) {
+    return WriteGathered(chain, "sendmsg", [fd, flags](iovec* iov, int count) {
+        msghdr message{};
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+        return sendmsg(fd, &message, flags);
+    });
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "sw_fwd.h"
+
+#include <common/reclaimer.h>
+
+// Opt-in: `SharedPtr<T, DeferredDestruction<Counting>>` hands an object whose last strong
+// reference is gone to `DeferredReclaimer` instead of destroying it inline. `WeakPtr`s see
+// the object as expired right away; the control block lives until the object is destroyed.
+// Wraps other disposal policies, e.g. `DeferredDestruction<IterativeDestruction<Counting>>`
+// destroys long chains on the reclaimer thread without recursion.
+template <typename Counting>
+class DeferredDestruction : public Counting {
+public:
+    template <typename Block>
+    static void Dispose(Block* block) {
+        DeferredReclaimer::Defer(block, &DisposeNow<Block>);
+    }
+
+private:
+    template <typename Block>
+    static void DisposeNow(void* object) {
+        Block* block = static_cast<Block*>(object);
+        if constexpr (HasCustomDisposal<Counting, Block>::value) {
+            Counting::Dispose(block);
+        } else {
+            block->Dispose();
+        }
+    }
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "sw_fwd.h"
+
+#include <common/epoch.h>
+
+// Opt-in: `SharedPtr<T, EpochDestruction<Counting>>` retires an object whose last strong
+// reference is gone to `EpochDomain`, so readers inside an `EpochGuard` may keep using raw
+// pointers to it (`Get()` copied out of a holder) without taking references. `WeakPtr`s see
+// the object as expired right away; the control block lives until the object is destroyed.
+template <typename Counting>
+class EpochDestruction : public Counting {
+public:
+    template <typename Block>
+    static void Dispose(Block* block) {
+        EpochDomain::Retire(block, &DisposeNow<Block>);
+    }
+
+private:
+    template <typename Block>
+    static void DisposeNow(void* object) {
+        Block* block = static_cast<Block*>(object);
+        if constexpr (HasCustomDisposal<Counting, Block>::value) {
+            Counting::Dispose(block);
+        } else {
+            block->Dispose();
+        }
+    }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "thin.h"
+
+#include <common/hazard.h>
+
+#include <atomic>
+#include <utility>
+
+// Holder of a published `MakeShared` object that readers dereference under a `HazardPointer`
+// without touching its counter. The holder owns one strong reference to the current object;
+// a replaced object's reference is retired to the `HazardDomain` and dropped once no hazard
+// covers its control block.
+template <typename T>
+class HazardSharedPtr {
+public:
+    using Value = ThinSharedPtr<T, AtomicCounting>;
+
+    HazardSharedPtr() = default;
+
+    // Use `ThinSharedPtr::FromShared` or `MakeThinShared` to get a `Value`.
+    HazardSharedPtr(Value value) : block_(std::exchange(value.block_, nullptr)) {
+    }
+
+    HazardSharedPtr(const HazardSharedPtr&) = delete;
+    HazardSharedPtr& operator=(const HazardSharedPtr&) = delete;
+
+    ~HazardSharedPtr() {
+        Retire(block_.load(std::memory_order_relaxed));
+    }
+
+    void Store(Value desired) {
+        Retire(block_.exchange(std::exchange(desired.block_, nullptr), std::memory_order_seq_cst));
+    }
+
+    // The object stays alive until `hazard` protects something else or is reset.
+    T* Protect(HazardPointer& hazard) const {
+        Block* block = hazard.Protect(block_);
+        return block == nullptr ? nullptr : block->GetObject();
+    }
+
+    // Takes a strong reference to the current object; `hazard` is reset afterwards.
+    SharedPtr<T, AtomicCounting> Load(HazardPointer& hazard) const {
+        Block* block = hazard.Protect(block_);
+        if (block == nullptr) {
+            return SharedPtr<T, AtomicCounting>();
+        }
+        // The holder's reference is not dropped while the hazard covers the block.
+        block->GetCounting().IncStrong();
+        hazard.Reset();
+        return Value(block).ToShared();
+    }
+
+private:
+    using Block = typename Value::Block;
+
+    static void Retire(Block* block) {
+        if (block != nullptr) {
+            HazardDomain::Retire(block, [](void* object) {
+                static_cast<Block*>(object)->ReleaseStrong();
+            });
+        }
+    }
+
+    std::atomic<Block*> block_ = nullptr;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "shared.h"
+
+#include <type_traits>
+#include <utility>
+
+// A static object handed out as `SharedPtr<T, Counting>` without a control-block allocation:
+// the block sits next to the object, both are built at compile time when `T` allows it, and
+// neither is ever destroyed. Copies and releases of the pointers only read the counters, so
+// the line they live on stays shared between cores.
+//
+//     constinit ImmortalShared<const Config> kDefaults(8, "default");
+//     constinit SharedPtr<const Config, ImmortalAtomicCounting> kDefaultConfig(kDefaults);
+//
+// The counting policy must support immortal blocks, as `ImmortalAtomicCounting` does; the
+// pointers have that policy too. Only for objects with static storage duration: the object
+// outlives every pointer to it.
+template <typename T, typename Counting = ImmortalAtomicCounting>
+class ImmortalShared {
+public:
+    template <typename... Args>
+    constexpr explicit ImmortalShared(Args&&... args) : block_(std::forward<Args>(args)...) {
+        static_assert(std::is_constructible_v<Counting, ImmortalTag>,
+                      "Use a counting policy with immortal blocks, e.g. ImmortalAtomicCounting");
+        static_assert(!std::is_array_v<T>);
+        static_assert(!std::is_convertible_v<T*, EnableSharedFromThisBase*>,
+                      "EnableSharedFromThis is not supported");
+    }
+
+    ImmortalShared(const ImmortalShared&) = delete;
+    ImmortalShared& operator=(const ImmortalShared&) = delete;
+
+    constexpr T* Get() {
+        return &block_.object;
+    }
+    constexpr ControlBlock<Counting>* GetBlock() {
+        return &block_;
+    }
+
+    SharedPtr<T, Counting> Share() {
+        return SharedPtr<T, Counting>(*this);
+    }
+
+private:
+    class Block : public ControlBlock<Counting> {
+        using Base = ControlBlock<Counting>;
+
+    public:
+        template <typename... Args>
+        constexpr explicit Block(Args&&... args)
+            : Base(&kOps, ImmortalTag{}), object(std::forward<Args>(args)...) {
+        }
+        // The object is never destroyed.
+        ~Block() {
+        }
+
+        union {
+            T object;
+        };
+
+    private:
+        static constexpr typename Base::Ops kOps{nullptr, nullptr};
+    };
+
+    Block block_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "sw_fwd.h"
+
+// Opt-in: `SharedPtr<T, IterativeDestruction<Counting>>` releases long chains
+// (lists, deep trees) in a loop instead of recursing once per node.
+//
+// The first disposal on a thread drains a thread-local pending list. A block whose last
+// strong reference drops while the list is being drained (that is, from inside the
+// destructor of another object) is pushed to the list instead of being disposed in place.
+// Blocks are linked through the policy, so pushing never allocates.
+template <typename Counting>
+class IterativeDestruction : public Counting {
+public:
+    template <typename Block>
+    static void Dispose(Block* block) {
+        if (draining<Block>) {
+            block->GetCounting().next_pending_ = pending<Block>;
+            pending<Block> = block;
+            return;
+        }
+        draining<Block> = true;
+        block->Dispose();
+        while (pending<Block> != nullptr) {
+            Block* next = pending<Block>;
+            pending<Block> = static_cast<Block*>(next->GetCounting().next_pending_);
+            next->Dispose();
+        }
+        draining<Block> = false;
+    }
+
+private:
+    void* next_pending_ = nullptr;
+
+    template <typename Block>
+    static inline thread_local Block* pending = nullptr;
+    template <typename Block>
+    static inline thread_local bool draining = false;
+};
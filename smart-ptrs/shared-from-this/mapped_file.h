@@ -0,0 +1,102 @@
+#pragma once
+
+#include "buffer.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Access-pattern hints passed to `madvise`. They are best effort: a kernel that does not
+// support one ignores it.
+enum class MapAdvice {
+    kNormal,
+    kSequential,
+    kRandom,
+    kWillNeed,
+    kHugePage,
+};
+
+// Owns a mapped region; `SharedPtr` calls it once the last view is gone.
+struct Unmap {
+    size_t size;
+
+    void operator()(std::byte* data) const {
+        munmap(data, size);
+    }
+};
+
+// Applies `advice` to the pages under `buffer`.
+template <typename Counting>
+void Advise(const SharedBuffer<Counting>& buffer, MapAdvice advice) {
+    if (buffer.Empty()) {
+        return;
+    }
+    int native = MADV_NORMAL;
+    switch (advice) {
+        case MapAdvice::kNormal:
+            break;
+        case MapAdvice::kSequential:
+            native = MADV_SEQUENTIAL;
+            break;
+        case MapAdvice::kRandom:
+            native = MADV_RANDOM;
+            break;
+        case MapAdvice::kWillNeed:
+            native = MADV_WILLNEED;
+            break;
+        case MapAdvice::kHugePage:
+#ifdef MADV_HUGEPAGE
+            native = MADV_HUGEPAGE;
+            break;
+#else
+            return;
+#endif
+    }
+    // `madvise` takes whole pages.
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(buffer.Data()) / page * page;
+    uintptr_t end = reinterpret_cast<uintptr_t>(buffer.Data()) + buffer.Size();
+    madvise(reinterpret_cast<void*>(begin), end - begin, native);
+}
+
+// Maps the whole file at `path` read-only. Pages are read in lazily on first access, and the
+// mapping is released when the returned buffer and every slice or view of it are gone.
+// An empty file gives an empty buffer. Throws `std::system_error` if the file cannot be mapped.
+template <typename Counting = SingleThreadedCounting>
+SharedBuffer<Counting> MapFile(const char* path, MapAdvice advice = MapAdvice::kNormal) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+    size_t size = info.st_size;
+    if (size == 0) {
+        close(fd);
+        return SharedBuffer<Counting>();
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    // The mapping keeps the file alive on its own.
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::system_error(error, std::generic_category(), path);
+    }
+
+    using Storage = typename SharedBuffer<Counting>::Storage;
+    SharedBuffer<Counting> buffer(Storage(static_cast<std::byte*>(data), Unmap{size}), size);
+    if (advice != MapAdvice::kNormal) {
+        Advise(buffer, advice);
+    }
+    return buffer;
+}
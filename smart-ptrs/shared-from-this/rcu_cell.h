@@ -0,0 +1,113 @@
+#pragma once
+
+#include "epoch_destruction.h"
+#include "thin.h"
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+// Read-copy-update holder of an immutable `T`, for hot snapshots such as configuration.
+//
+// `Read` is wait-free and never writes to a shared line: it enters an `EpochGuard` and loads
+// the published version. `Update` copies the current version, modifies the copy and publishes
+// it. Writers are serialized by a mutex that readers never take.
+//
+// The cell drops its reference to a replaced version only after an epoch grace period, so
+// `Load` always adds its reference while the cell still holds one. If that was the last
+// reference, `EpochDestruction` waits for a second grace period before destroying the version.
+template <typename T>
+class RcuCell {
+public:
+    using Counting = EpochDestruction<AtomicCounting>;
+    using Pointer = SharedPtr<const T, Counting>;
+
+    // Borrowed view of one version; valid until destroyed. Must stay on the thread that
+    // called `Read`.
+    class Snapshot {
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        const T* Get() const {
+            return value_;
+        }
+        const T& operator*() const {
+            return *value_;
+        }
+        const T* operator->() const {
+            return value_;
+        }
+
+    private:
+        friend class RcuCell;
+
+        explicit Snapshot(const RcuCell& cell)
+            : value_(cell.published_.load(std::memory_order_acquire)->GetObject()) {
+        }
+
+        EpochGuard guard_;
+        const T* value_;
+    };
+
+    template <typename... Args>
+    explicit RcuCell(Args&&... args)
+        : published_(Publish(MakeThinShared<T, Counting>(std::forward<Args>(args)...))) {
+    }
+
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    ~RcuCell() {
+        published_.load(std::memory_order_relaxed)->ReleaseStrong();
+    }
+
+    Snapshot Read() const {
+        return Snapshot(*this);
+    }
+
+    // Shares ownership of the current version, for keeping it past a snapshot.
+    Pointer Load() const {
+        EpochGuard guard;
+        Block* block = published_.load(std::memory_order_acquire);
+        // The cell's reference outlives the guard: this increment never revives a dead object.
+        block->GetCounting().IncStrong();
+        return Value(block).ToShared();
+    }
+
+    // Publishes a copy of the current version modified by `fn(T&)`.
+    template <typename F>
+    void Update(F&& fn) {
+        std::lock_guard guard(mutex_);
+        auto fresh = MakeThinShared<T, Counting>(
+            *published_.load(std::memory_order_relaxed)->GetObject());
+        fn(*fresh);
+        Replace(std::move(fresh));
+    }
+
+    // Publishes `value` as the new version.
+    void Store(T value) {
+        auto fresh = MakeThinShared<T, Counting>(std::move(value));
+        std::lock_guard guard(mutex_);
+        Replace(std::move(fresh));
+    }
+
+private:
+    using Value = ThinSharedPtr<T, Counting>;
+    using Block = typename Value::Block;
+
+    static Block* Publish(Value value) {
+        return std::exchange(value.block_, nullptr);
+    }
+
+    // Called with `mutex_` held. Guards entered before the exchange may still be loading
+    // `current`: its reference is dropped once they are gone.
+    void Replace(Value fresh) {
+        Block* current = published_.exchange(Publish(std::move(fresh)), std::memory_order_release);
+        EpochDomain::Retire(current,
+                            [](void* block) { static_cast<Block*>(block)->ReleaseStrong(); });
+    }
+
+    std::mutex mutex_;
+    std::atomic<Block*> published_;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "shared.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Strong counts spread over padded slots, one per group of threads, so copies made on
+// different cores do not fight over one cache line. The sum over the slots is not known
+// while the object is live: a base reference, held by `ShardedSharedPtr`, keeps it alive.
+// Teardown moves the slots into one atomic counter, after which every update goes there.
+// Use it through `ShardedSharedPtr`: without the base reference being dropped by `Kill`,
+// the object is never destroyed.
+class ShardedCounting {
+public:
+    static constexpr size_t kShards = 32;
+
+    void IncStrong() {
+        if (IsKilled(LocalShard().fetch_add(1, std::memory_order_relaxed))) {
+            central_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    bool TryIncStrong() {
+        if (!IsKilled(LocalShard().fetch_add(1, std::memory_order_relaxed))) {
+            return true;
+        }
+        int64_t count = central_.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (central_.compare_exchange_weak(count, count + 1, std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool DecStrong() {
+        if (!IsKilled(LocalShard().fetch_sub(1, std::memory_order_release))) {
+            return false;
+        }
+        return central_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    void IncWeak() {
+        weak_counter_.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool DecWeak() {
+        if (weak_counter_.load(std::memory_order_acquire) == 1) {
+            return true;
+        }
+        return weak_counter_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    // Approximate while the slots are live.
+    size_t StrongCount() const {
+        int64_t count = central_.load(std::memory_order_acquire);
+        for (const Shard& shard : shards_) {
+            int64_t value = shard.count.load(std::memory_order_relaxed);
+            if (!IsKilled(value)) {
+                count += value;
+            }
+        }
+        return count < 0 ? 0 : count;
+    }
+
+    // Moves the slots into the central counter. Updates that race with it land either in a
+    // slot before it is moved or in the central counter; a bias keeps the central counter
+    // from reaching zero in between. Called once, while the base reference is still held.
+    void Kill() {
+        central_.fetch_add(kBias, std::memory_order_relaxed);
+        int64_t sum = 0;
+        for (Shard& shard : shards_) {
+            sum += shard.count.exchange(kKilled, std::memory_order_acq_rel);
+        }
+        central_.fetch_add(sum - kBias, std::memory_order_acq_rel);
+    }
+
+private:
+    // Killed slots hold this value; stray updates after that drift around it but never get
+    // anywhere near a live count.
+    static constexpr int64_t kKilled = int64_t{1} << 62;
+    static constexpr int64_t kKilledThreshold = int64_t{1} << 61;
+    static constexpr int64_t kBias = int64_t{1} << 40;
+
+    struct alignas(64) Shard {
+        std::atomic<int64_t> count = 0;
+    };
+
+    static bool IsKilled(int64_t value) {
+        return value >= kKilledThreshold;
+    }
+
+    std::atomic<int64_t>& LocalShard() {
+        return shards_[tls_shard].count;
+    }
+
+    Shard shards_[kShards];
+    // Holds the base reference until `Kill`.
+    alignas(64) std::atomic<int64_t> central_ = 1;
+    std::atomic<int> weak_counter_ = 1;
+
+    static inline std::atomic<size_t> next_shard = 0;
+    static inline thread_local size_t tls_shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+};
+
+// Owner of a very hot shared object: hands out `SharedPtr<T, ShardedCounting>` copies whose
+// count updates stay on the copying core's slot. Destroying (or resetting) it reconciles the
+// slots; the object then dies with the last copy.
+template <typename T>
+class ShardedSharedPtr {
+public:
+    using Pointer = SharedPtr<T, ShardedCounting>;
+
+    ShardedSharedPtr() = default;
+
+    ShardedSharedPtr(const ShardedSharedPtr&) = delete;
+    ShardedSharedPtr& operator=(const ShardedSharedPtr&) = delete;
+
+    ShardedSharedPtr(ShardedSharedPtr&& other) : base_(std::move(other.base_)) {
+    }
+    ShardedSharedPtr& operator=(ShardedSharedPtr&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        Reset();
+        base_ = std::move(other.base_);
+        return *this;
+    }
+
+    ~ShardedSharedPtr() {
+        Reset();
+    }
+
+    void Reset() {
+        if (base_.block_ != nullptr) {
+            base_.block_->GetCounting().Kill();
+            base_.Reset();
+        }
+    }
+
+    // A copy sharing ownership of the object.
+    Pointer Share() const {
+        return base_;
+    }
+
+    T* Get() const {
+        return base_.Get();
+    }
+    T& operator*() const {
+        return *base_;
+    }
+    T* operator->() const {
+        return base_.Get();
+    }
+    explicit operator bool() const {
+        return static_cast<bool>(base_);
+    }
+
+    template <typename U, typename... Args>
+    friend ShardedSharedPtr<U> MakeShardedShared(Args&&... args);
+
+private:
+    explicit ShardedSharedPtr(Pointer base) : base_(std::move(base)) {
+    }
+
+    Pointer base_;
+};
+
+// Allocate memory only once
+template <typename T, typename... Args>
+ShardedSharedPtr<T> MakeShardedShared(Args&&... args) {
+    return ShardedSharedPtr<T>(MakeShared<T, ShardedCounting>(std::forward<Args>(args)...));
+}
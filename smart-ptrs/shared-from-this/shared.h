@@ -8,45 +8,67 @@
 // https://en.cppreference.com/w/cpp/memory/shared_ptr
 class EnableSharedFromThisBase {};
 
-template <typename T>
+template <typename T, typename Counting = SingleThreadedCounting>
 class EnableSharedFromThis : public EnableSharedFromThisBase {
 public:
-    template <typename Pointer>
+    template <typename Pointer, typename C>
     friend class SharedPtr;
 
-    SharedPtr<T> SharedFromThis() {
+    SharedPtr<T, Counting> SharedFromThis() {
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
-            return SharedPtr<T>(weak_ptr_);
+            return SharedPtr<T, Counting>(weak_ptr_);
         }
     }
-    SharedPtr<const T> SharedFromThis() const {
+    SharedPtr<const T, Counting> SharedFromThis() const {
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
-            return SharedPtr<T>(weak_ptr_);
+            return SharedPtr<T, Counting>(weak_ptr_);
         }
     }
 
-    WeakPtr<T> WeakFromThis() noexcept {
+    WeakPtr<T, Counting> WeakFromThis() noexcept {
         return weak_ptr_;
     }
-    WeakPtr<const T> WeakFromThis() const noexcept {
+    WeakPtr<const T, Counting> WeakFromThis() const noexcept {
         return weak_ptr_;
     }
 
 protected:
-    WeakPtr<T> weak_ptr_;
+    WeakPtr<T, Counting> weak_ptr_;
+};
+
+// A strong reference taken out of a `SharedPtr` by `Detach`; give it back with `Adopt`.
+template <typename T, typename Counting = SingleThreadedCounting>
+struct DetachedShared {
+    std::remove_extent_t<T>* pointer = nullptr;
+    ControlBlock<Counting>* block = nullptr;
 };
 
-template <typename T>
+template <typename T, typename Counting>
 class SharedPtr {
 public:
-    template <typename Pointer>
+    template <typename Pointer, typename C>
     friend class SharedPtr;
 
-    template <typename Pointer>
+    template <typename Pointer, typename C>
     friend class WeakPtr;
 
-    template <class P>
+    template <class P, typename C>
     friend class EnableSharedFromThis;
+
+    template <typename P>
+    friend class AtomicSharedPtr;
+
+    template <typename P, typename C>
+    friend class ThinSharedPtr;
+
+    template <typename P>
+    friend class ShardedSharedPtr;
+
+    template <typename P, typename C>
+    friend class BorrowedShared;
+
+    // `T` for single objects, `U` for `U[]` and `U[N]`.
+    using ElementType = std::remove_extent_t<T>;
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
 
@@ -60,60 +82,83 @@ public:
         pointer_ = nullptr;
     }
 
-    explicit SharedPtr(T* ptr) {
+    explicit SharedPtr(ElementType* ptr) {
         pointer_ = ptr;
-        block_ = new ControlBlockForExistedObject<T>(ptr);
+        block_ = AllocateDefaultBlock(ptr);
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
             InitializeWeak(ptr);
         }
     }
 
     template <typename Y>
-    void InitializeWeak(EnableSharedFromThis<Y>* enable_shated_object) {
+    void InitializeWeak(EnableSharedFromThis<Y, Counting>* enable_shated_object) {
         enable_shated_object->weak_ptr_ = *this;
     }
 
     template <class Pointer>
     explicit SharedPtr(Pointer* ptr) {
         pointer_ = ptr;
-        block_ = new ControlBlockForExistedObject<Pointer>(ptr);
+        block_ = AllocateDefaultBlock(ptr);
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
             InitializeWeak(ptr);
         }
     }
 
-    SharedPtr(ControlBlockForNewObject<T>* block) {
-        block_ = block;
-        pointer_ = block->GetObject();
+    // The object is destroyed with `deleter`, kept inside the control block.
+    // If the block cannot be allocated, `deleter` is called on `ptr`.
+    template <class Pointer, class Deleter,
+              class = std::enable_if_t<std::is_invocable_v<Deleter&, Pointer*>>>
+    SharedPtr(Pointer* ptr, Deleter deleter)
+        : SharedPtr(ptr, std::move(deleter), DefaultBlockAllocator<Counting, Pointer>()) {
+    }
+
+    // The control block is allocated with `alloc`, the object is destroyed with `deleter`.
+    // If the block cannot be allocated, `deleter` is called on `ptr`.
+    template <class Pointer, class Deleter, class Alloc>
+    SharedPtr(Pointer* ptr, Deleter deleter, Alloc alloc) {
+        pointer_ = ptr;
+        try {
+            block_ = AllocateControlBlock<
+                ControlBlockForExistedObject<Pointer, Counting, Deleter, Alloc>>(
+                alloc, ptr, deleter, alloc);
+        } catch (...) {
+            deleter(ptr);
+            throw;
+        }
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
-            InitializeWeak(pointer_);
+            InitializeWeak(ptr);
         }
     }
 
-    template <class Pointer>
-    SharedPtr(ControlBlockForNewObject<Pointer>* block) {
+    template <class Pointer, class Alloc>
+    SharedPtr(ControlBlockForNewObject<Pointer, Counting, Alloc>* block) {
         block_ = block;
         pointer_ = block->GetObject();
-        ++block_->GetStrongCounter();
         if constexpr (std::is_convertible_v<T*, EnableSharedFromThisBase*>) {
             InitializeWeak(pointer_);
         }
     }
 
+    template <class Alloc>
+    SharedPtr(ControlBlockForNewArray<ElementType, Counting, Alloc>* block) {
+        block_ = block;
+        pointer_ = block->GetObject();
+    }
+
     SharedPtr(const SharedPtr& other) {
         pointer_ = other.pointer_;
         block_ = other.block_;
         if (other.block_ != nullptr) {
-            ++block_->GetStrongCounter();
+            block_->GetCounting().IncStrong();
         }
     }
 
     template <class Pointer>
-    SharedPtr(const SharedPtr<Pointer>& other) {
+    SharedPtr(const SharedPtr<Pointer, Counting>& other) {
         pointer_ = other.pointer_;
         block_ = other.block_;
         if (other.block_ != nullptr) {
-            ++block_->GetStrongCounter();
+            block_->GetCounting().IncStrong();
         }
     }
 
@@ -125,7 +170,7 @@ public:
     }
 
     template <class Pointer>
-    SharedPtr(SharedPtr<Pointer>&& other) {
+    SharedPtr(SharedPtr<Pointer, Counting>&& other) {
         pointer_ = other.pointer_;
         block_ = std::move(other.block_);
         other.block_ = nullptr;
@@ -135,30 +180,34 @@ public:
     // Aliasing constructor
     // #8 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
     template <typename Pointer>
-    SharedPtr(const SharedPtr<Pointer>& other, T* ptr) {
+    SharedPtr(const SharedPtr<Pointer, Counting>& other, ElementType* ptr) {
         this->pointer_ = ptr;
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
         this->block_ = other.block_;
-        ++block_->GetStrongCounter();
+        if (block_ != nullptr) {
+            block_->GetCounting().IncStrong();
+        }
+    }
+
+    // Takes over the reference of `other` instead of adding one.
+    template <typename Pointer>
+    SharedPtr(SharedPtr<Pointer, Counting>&& other, ElementType* ptr) {
+        this->pointer_ = ptr;
+        this->block_ = std::exchange(other.block_, nullptr);
+        other.pointer_ = nullptr;
+    }
+
+    // Shares an immortal object without touching any counter; usable in `constinit`.
+    template <class Pointer>
+    constexpr SharedPtr(ImmortalShared<Pointer, Counting>& object)
+        : pointer_(object.Get()), block_(object.GetBlock()) {
     }
 
     // Promote `WeakPtr`
     // #11 from https://en.cppreference.com/w/cpp/memory/shared_ptr/shared_ptr
-    explicit SharedPtr(const WeakPtr<T>& other) {
-        if (other.Expired()) {
+    explicit SharedPtr(const WeakPtr<T, Counting>& other) {
+        if (!other.TryLock(*this)) {
             throw BadWeakPtr();
         }
-        this->block_ = other.block_weak_;
-        this->pointer_ = other.object_;
-        ++this->block_->GetStrongCounter();
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -168,20 +217,12 @@ public:
         if (this == &other) {
             return *this;
         }
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
+        if (other.block_ != nullptr) {
+            other.block_->GetCounting().IncStrong();
         }
+        ReleaseBlock();
         block_ = other.block_;
         pointer_ = other.pointer_;
-        if (block_ != nullptr) {
-            ++block_->GetStrongCounter();
-        }
         return *this;
     }
 
@@ -189,15 +230,7 @@ public:
         if (this == &other) {
             return *this;
         }
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        ReleaseBlock();
         block_ = std::move(other.block_);
         pointer_ = other.pointer_;
         other.block_ = nullptr;
@@ -209,82 +242,73 @@ public:
     // Destructor
 
     ~SharedPtr() {
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        ReleaseBlock();
     };
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Modifiers
 
     void Reset() {
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        ReleaseBlock();
         pointer_ = nullptr;
         block_ = nullptr;
     }
-    void Reset(T* ptr) {
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
+    void Reset(ElementType* ptr) {
+        ReleaseBlock();
         this->pointer_ = ptr;
-        block_ = new ControlBlockForExistedObject(ptr);
+        block_ = AllocateDefaultBlock(ptr);
     }
     template <class Pointer>
     void Reset(Pointer* ptr) {
-        if (block_) {
-            --block_->GetStrongCounter();
-            if (block_->GetStrongCounter() == 0 && block_->GetWeakCounter() == 0) {
-                block_->DeleteObject();
-                delete block_;
-            } else if (block_->GetStrongCounter() == 0) {
-                block_->DeleteObject();
-            }
-        }
+        ReleaseBlock();
         this->pointer_ = ptr;
-        block_ = new ControlBlockForExistedObject(ptr);
+        block_ = AllocateDefaultBlock(ptr);
     }
     void Swap(SharedPtr& other) {
         std::swap(this->pointer_, other.pointer_);
         std::swap(this->block_, other.block_);
     }
 
+    // Takes over the strong reference in `detached`: no count update.
+    static SharedPtr Adopt(DetachedShared<T, Counting> detached) {
+        return SharedPtr(detached.block, detached.pointer);
+    }
+    // Gives up ownership without releasing the strong reference: the caller now owns it.
+    DetachedShared<T, Counting> Detach() {
+        return {std::exchange(pointer_, nullptr), std::exchange(block_, nullptr)};
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Observers
 
-    T* Get() const {
+    ElementType* Get() const {
         return pointer_;
     }
-    T& operator*() const {
+    ElementType& operator*() const {
+        static_assert(!std::is_array_v<T>);
         return *pointer_;
     }
-    T* operator->() const {
+    ElementType* operator->() const {
+        static_assert(!std::is_array_v<T>);
         return pointer_;
     }
+    ElementType& operator[](std::ptrdiff_t index) const {
+        static_assert(std::is_array_v<T>);
+        return pointer_[index];
+    }
     size_t UseCount() const {
         if (!block_) {
             return 0;
         }
-        return block_->GetStrongCounter();
+        return block_->GetCounting().StrongCount();
+    }
+    // The deleter the object was adopted with if it is a `D`, otherwise nullptr.
+    template <typename D>
+    D* GetDeleter() const {
+        if (!block_) {
+            return nullptr;
+        }
+        return static_cast<D*>(block_->GetDeleter(TypeTag<D>()));
     }
     explicit operator bool() const {
         if (block_) {
@@ -294,19 +318,107 @@ public:
     }
 
 private:
-    T* pointer_;
-    ControlBlock* block_ = nullptr;
+    // Takes over a strong reference the caller already owns.
+    SharedPtr(ControlBlock<Counting>* block, ElementType* ptr) {
+        block_ = block;
+        pointer_ = ptr;
+    }
+
+    // Arrays from `new U[n]` are freed with `delete[]`.
+    template <class Pointer>
+    static ControlBlock<Counting>* AllocateDefaultBlock(Pointer* ptr) {
+        using Alloc = DefaultBlockAllocator<Counting, Pointer>;
+        using Deleter =
+            std::conditional_t<std::is_array_v<T>, std::default_delete<Pointer[]>,
+                               std::default_delete<Pointer>>;
+        try {
+            return AllocateControlBlock<
+                ControlBlockForExistedObject<Pointer, Counting, Deleter, Alloc>>(Alloc(), ptr,
+                                                                                 Deleter(), Alloc());
+        } catch (...) {
+            Deleter()(ptr);
+            throw;
+        }
+    }
+
+    void ReleaseBlock() {
+        if (block_) {
+            block_->ReleaseStrong();
+        }
+    }
+
+    ElementType* pointer_;
+    ControlBlock<Counting>* block_ = nullptr;
 };
 
-template <typename T, typename U>
-inline bool operator==(const SharedPtr<T>& left, const SharedPtr<U>& right) {
+template <typename T, typename U, typename Counting>
+inline bool operator==(const SharedPtr<T, Counting>& left, const SharedPtr<U, Counting>& right) {
     return left.Get() == right.Get();
 }
 
+// Allocate memory only once, from `alloc`
+template <typename T, typename Counting = SingleThreadedCounting, typename Alloc,
+          typename... Args>
+std::enable_if_t<!std::is_array_v<T>, SharedPtr<T, Counting>> AllocateShared(const Alloc& alloc,
+                                                                             Args&&... args) {
+    return SharedPtr<T, Counting>(AllocateControlBlock<ControlBlockForNewObject<T, Counting, Alloc>>(
+        alloc, alloc, std::forward<Args>(args)...));
+}
+
 // Allocate memory only once
-template <typename T, typename... Args>
-SharedPtr<T> MakeShared(Args&&... args) {
-    return SharedPtr<T>(new ControlBlockForNewObject<T>(std::forward<Args>(args)...));
+template <typename T, typename Counting = SingleThreadedCounting, typename... Args>
+std::enable_if_t<!std::is_array_v<T>, SharedPtr<T, Counting>> MakeShared(Args&&... args) {
+    return AllocateShared<T, Counting>(DefaultBlockAllocator<Counting, T>(),
+                                       std::forward<Args>(args)...);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Arrays: the counters and the elements share one cache-aligned allocation.
+
+template <typename T, typename Counting, typename Alloc>
+SharedPtr<T, Counting> AllocateSharedArray(const Alloc& alloc, size_t size, bool for_overwrite) {
+    using Element = std::remove_extent_t<T>;
+    using ElementAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Element>;
+    return SharedPtr<T, Counting>(ControlBlockForNewArray<Element, Counting, ElementAlloc>::Create(
+        ElementAlloc(alloc), size, for_overwrite));
+}
+
+// `size` value-initialized elements
+template <typename T, typename Counting = SingleThreadedCounting, typename Alloc>
+std::enable_if_t<std::is_unbounded_array_v<T>, SharedPtr<T, Counting>> AllocateShared(
+    const Alloc& alloc, size_t size) {
+    return AllocateSharedArray<T, Counting>(alloc, size, false);
+}
+
+template <typename T, typename Counting = SingleThreadedCounting, typename Alloc>
+std::enable_if_t<std::is_bounded_array_v<T>, SharedPtr<T, Counting>> AllocateShared(
+    const Alloc& alloc) {
+    return AllocateSharedArray<T, Counting>(alloc, std::extent_v<T>, false);
+}
+
+template <typename T, typename Counting = SingleThreadedCounting>
+std::enable_if_t<std::is_unbounded_array_v<T>, SharedPtr<T, Counting>> MakeShared(size_t size) {
+    return AllocateShared<T, Counting>(DefaultBlockAllocator<Counting, std::remove_extent_t<T>>(),
+                                       size);
+}
+
+template <typename T, typename Counting = SingleThreadedCounting>
+std::enable_if_t<std::is_bounded_array_v<T>, SharedPtr<T, Counting>> MakeShared() {
+    return AllocateShared<T, Counting>(DefaultBlockAllocator<Counting, std::remove_extent_t<T>>());
+}
+
+// Elements are default-initialized: buffers of trivial types are left unwritten.
+template <typename T, typename Counting = SingleThreadedCounting>
+std::enable_if_t<std::is_unbounded_array_v<T>, SharedPtr<T, Counting>> MakeSharedForOverwrite(
+    size_t size) {
+    return AllocateSharedArray<T, Counting>(
+        DefaultBlockAllocator<Counting, std::remove_extent_t<T>>(), size, true);
+}
+
+template <typename T, typename Counting = SingleThreadedCounting>
+std::enable_if_t<std::is_bounded_array_v<T>, SharedPtr<T, Counting>> MakeSharedForOverwrite() {
+    return AllocateSharedArray<T, Counting>(
+        DefaultBlockAllocator<Counting, std::remove_extent_t<T>>(), std::extent_v<T>, true);
 }
 
 // Look for usage examples in tests
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "sw_fwd.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+struct SlabStats {
+    size_t chunks = 0;
+    // Blocks carved or ready to be carved from the chunks.
+    size_t capacity = 0;
+    // Blocks handed out and not returned yet.
+    size_t in_use = 0;
+
+    double Occupancy() const {
+        return capacity == 0 ? 0.0 : static_cast<double>(in_use) / capacity;
+    }
+};
+
+// Size-class slab allocator for small same-sized blocks such as control blocks.
+//
+// Each thread owns a heap with a free list per size class (its magazine), so an allocation
+// is a free list pop and a free on the owning thread is a push. Blocks freed by other
+// threads go to a lock-free remote list of the owning heap, which the owner takes over
+// in one exchange when its free list runs dry. Memory comes in chunks aligned to their
+// size, so the owner of a block is found by masking its address.
+// Heaps are never destroyed: a heap of an exited thread is handed to the next new thread.
+class ControlBlockSlab {
+public:
+    static constexpr size_t kGranularity = 16;
+    static constexpr size_t kMaxBlockSize = 256;
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    static constexpr bool Fits(size_t size, size_t alignment) {
+        return size <= kMaxBlockSize && alignment <= kGranularity;
+    }
+
+    // `size` must satisfy `Fits`.
+    static void* Allocate(size_t size) {
+        size_t index = ClassIndex(size);
+        if (Heap* heap = CurrentHeap()) {
+            return heap->classes[index].Pop(heap, index);
+        }
+        // The calling thread is exiting and has no heap: share one under the lock.
+        std::lock_guard guard(registry_mutex);
+        if (exiting_threads_heap == nullptr) {
+            exiting_threads_heap = NewHeap();
+        }
+        return exiting_threads_heap->classes[index].Pop(exiting_threads_heap, index);
+    }
+
+    // `ptr` must come from `Allocate`; frees on a thread other than the owner are pushed
+    // to the remote list of the owning heap.
+    static void Deallocate(void* ptr, size_t) {
+        Chunk* chunk = ChunkOf(ptr);
+        SizeClass& size_class = chunk->owner->classes[chunk->class_index];
+        if (chunk->owner == tls_heap) {
+            size_class.PushLocal(static_cast<FreeBlock*>(ptr));
+        } else {
+            size_class.PushRemote(static_cast<FreeBlock*>(ptr));
+        }
+    }
+
+    // Occupancy of all heaps.
+    static SlabStats GetStats() {
+        SlabStats stats;
+        for (size_t index = 0; index < kNumClasses; ++index) {
+            SlabStats class_stats = GetStats((index + 1) * kGranularity);
+            stats.chunks += class_stats.chunks;
+            stats.capacity += class_stats.capacity;
+            stats.in_use += class_stats.in_use;
+        }
+        return stats;
+    }
+
+    // Occupancy of the size class serving blocks of `size` bytes.
+    static SlabStats GetStats(size_t size) {
+        size_t index = ClassIndex(size);
+        SlabStats stats;
+        std::lock_guard guard(registry_mutex);
+        for (Heap* heap = all_heaps; heap != nullptr; heap = heap->next) {
+            const SizeClass& size_class = heap->classes[index];
+            size_t chunks = size_class.chunks.load(std::memory_order_relaxed);
+            stats.chunks += chunks;
+            stats.capacity += chunks * BlocksPerChunk(index);
+            stats.in_use += size_class.allocated.load(std::memory_order_relaxed) -
+                            size_class.freed.load(std::memory_order_relaxed) -
+                            size_class.remote_freed.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    static constexpr size_t kNumClasses = kMaxBlockSize / kGranularity;
+    static constexpr size_t kHeaderSize = 64;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Heap;
+
+    struct alignas(kHeaderSize) Chunk {
+        Heap* owner;
+        size_t class_index;
+    };
+
+    // Counters are written by the owning thread only, so plain stores suffice.
+    static void Bump(std::atomic<size_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    struct SizeClass {
+        FreeBlock* free = nullptr;
+        char* bump = nullptr;
+        char* end = nullptr;
+        std::atomic<size_t> chunks = 0;
+        std::atomic<size_t> allocated = 0;
+        std::atomic<size_t> freed = 0;
+
+        // Written by other threads: keep off the owner's cache line.
+        alignas(64) std::atomic<FreeBlock*> remote = nullptr;
+        std::atomic<size_t> remote_freed = 0;
+
+        void* Pop(Heap* heap, size_t index) {
+            if (free == nullptr) {
+                free = remote.exchange(nullptr, std::memory_order_acquire);
+            }
+            Bump(allocated);
+            if (free != nullptr) {
+                FreeBlock* block = free;
+                free = block->next;
+                return block;
+            }
+            if (bump == end) {
+                Refill(heap, index);
+            }
+            void* block = bump;
+            bump += BlockSize(index);
+            return block;
+        }
+
+        void PushLocal(FreeBlock* block) {
+            block->next = free;
+            free = block;
+            Bump(freed);
+        }
+
+        void PushRemote(FreeBlock* block) {
+            block->next = remote.load(std::memory_order_relaxed);
+            while (!remote.compare_exchange_weak(block->next, block, std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+            }
+            remote_freed.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Refill(Heap* heap, size_t index) {
+            void* memory = ::operator new(kChunkSize, std::align_val_t(kChunkSize));
+            Chunk* chunk = ::new (memory) Chunk{heap, index};
+            bump = reinterpret_cast<char*>(chunk) + kHeaderSize;
+            end = bump + BlocksPerChunk(index) * BlockSize(index);
+            Bump(chunks);
+        }
+    };
+
+    struct Heap {
+        SizeClass classes[kNumClasses];
+        Heap* next = nullptr;
+        Heap* next_abandoned = nullptr;
+    };
+
+    // Gives the heap of the exiting thread to the next new thread.
+    struct HeapGuard {
+        ~HeapGuard() {
+            std::lock_guard guard(registry_mutex);
+            tls_heap->next_abandoned = abandoned_heaps;
+            abandoned_heaps = tls_heap;
+            tls_heap = nullptr;
+            tls_exited = true;
+        }
+    };
+
+    static Heap* CurrentHeap() {
+        if (tls_heap == nullptr && !tls_exited) {
+            AcquireHeap();
+        }
+        return tls_heap;
+    }
+
+    static void AcquireHeap() {
+        {
+            std::lock_guard guard(registry_mutex);
+            if (abandoned_heaps != nullptr) {
+                tls_heap = abandoned_heaps;
+                abandoned_heaps = tls_heap->next_abandoned;
+            } else {
+                tls_heap = NewHeap();
+            }
+        }
+        thread_local HeapGuard heap_guard;
+    }
+
+    // Called with `registry_mutex` held.
+    static Heap* NewHeap() {
+        Heap* heap = new Heap;
+        heap->next = all_heaps;
+        all_heaps = heap;
+        return heap;
+    }
+
+    static Chunk* ChunkOf(void* ptr) {
+        return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(ptr) & ~(kChunkSize - 1));
+    }
+
+    static constexpr size_t RoundUp(size_t size) {
+        return (size + kGranularity - 1) / kGranularity * kGranularity;
+    }
+    static constexpr size_t ClassIndex(size_t size) {
+        return size == 0 ? 0 : RoundUp(size) / kGranularity - 1;
+    }
+    static constexpr size_t BlockSize(size_t index) {
+        return (index + 1) * kGranularity;
+    }
+    static constexpr size_t BlocksPerChunk(size_t index) {
+        return (kChunkSize - kHeaderSize) / BlockSize(index);
+    }
+
+    static inline std::mutex registry_mutex;
+    static inline Heap* all_heaps = nullptr;
+    static inline Heap* abandoned_heaps = nullptr;
+    static inline Heap* exiting_threads_heap = nullptr;
+    static inline thread_local Heap* tls_heap = nullptr;
+    static inline thread_local bool tls_exited = false;
+};
+
+// Serves single small objects from `ControlBlockSlab` and everything else from the global heap.
+template <typename T>
+class SlabAllocator {
+public:
+    using value_type = T;
+
+    SlabAllocator() = default;
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        if (n == 1 && ControlBlockSlab::Fits(sizeof(T), alignof(T))) {
+            return static_cast<T*>(ControlBlockSlab::Allocate(sizeof(T)));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (n == 1 && ControlBlockSlab::Fits(sizeof(T), alignof(T))) {
+            ControlBlockSlab::Deallocate(ptr, sizeof(T));
+        } else {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U>&) const {
+        return true;
+    }
+};
+
+// Opt-in: `SharedPtr<T, SlabAllocated<AtomicCounting>>` takes its control blocks
+// (and `MakeShared` objects) from the slab instead of the global heap.
+template <typename Counting>
+class SlabAllocated : public Counting {
+public:
+    template <typename T>
+    using BlockAllocator = SlabAllocator<T>;
+};
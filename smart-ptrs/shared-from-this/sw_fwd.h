@@ -1,99 +1,738 @@
 #pragma once
 
+#include <unique/compressed_pair.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 // Instead of std::bad_weak_ptr
 class BadWeakPtr : public std::exception {};
 
-class ControlBlock {
-public:
-    virtual ~ControlBlock() = default;
+// Counting policies.
+// The weak counter holds one extra reference on behalf of all strong owners,
+// so the control block dies exactly when the weak counter drops to zero.
+// Policies constructible from `ImmortalTag`, such as `ImmortalAtomicCounting`, support
+// immortal blocks (see `ImmortalShared`): their counters are never written, and neither the
+// object nor the block is ever freed.
 
-    virtual int& GetStrongCounter() {
+struct ImmortalTag {
+    explicit ImmortalTag() = default;
+};
+
+// Plain integers: the cheapest mode, for pointers that never cross threads.
+class SingleThreadedCounting {
+public:
+    void IncStrong() {
+        ++strong_counter_;
+    }
+    // Adds a strong reference unless the object is already gone.
+    bool TryIncStrong() {
+        if (strong_counter_ == 0) {
+            return false;
+        }
+        ++strong_counter_;
+        return true;
+    }
+    // Returns true if the last strong reference is gone.
+    bool DecStrong() {
+        return --strong_counter_ == 0;
+    }
+    void IncWeak() {
+        ++weak_counter_;
+    }
+    // Returns true if the control block must be freed.
+    bool DecWeak() {
+        return --weak_counter_ == 0;
+    }
+    size_t StrongCount() const {
         return strong_counter_;
     }
-    virtual int& GetWeakCounter() {
-        return weak_counter_;
+
+private:
+    int strong_counter_ = 1;
+    int weak_counter_ = 1;
+};
+
+// Safe to copy and destroy pointers to the same object from different threads.
+// Both counters share one 64-bit word (strong in the low half, weak in the high half), so a
+// single load tells whether the releasing pointer is the only reference of any kind.
+class AtomicCounting {
+public:
+    AtomicCounting() = default;
+
+    void IncStrong() {
+        word_.fetch_add(kOneStrong, std::memory_order_relaxed);
+    }
+    // The caller must hold a weak reference: `DecStrong` relies on nobody else being able to
+    // revive a block whose only reference is the releasing one.
+    bool TryIncStrong() {
+        uint64_t word = word_.load(std::memory_order_relaxed);
+        while ((word & kStrongMask) != 0) {
+            assert((word >> kWeakShift) >= 2 && "TryIncStrong needs a weak reference");
+            if (word_.compare_exchange_weak(word, word + kOneStrong, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool DecStrong() {
+        // Nobody else holds a reference, and creating one takes a reference (`TryIncStrong`
+        // needs a weak one): skip the read-modify-write. The plain store keeps the word right
+        // for weak pointers the destructor may still create.
+        if (word_.load(std::memory_order_acquire) == kOneStrong + kOneWeak) {
+            word_.store(kOneWeak, std::memory_order_relaxed);
+            return true;
+        }
+        return (word_.fetch_sub(kOneStrong, std::memory_order_acq_rel) & kStrongMask) ==
+               kOneStrong;
+    }
+    void IncWeak() {
+        word_.fetch_add(kOneWeak, std::memory_order_relaxed);
+    }
+    bool DecWeak() {
+        if (word_.load(std::memory_order_acquire) == kOneWeak) {
+            return true;
+        }
+        return (word_.fetch_sub(kOneWeak, std::memory_order_acq_rel) >> kWeakShift) == 1;
+    }
+    size_t StrongCount() const {
+        return word_.load(std::memory_order_acquire) & kStrongMask;
     }
-    virtual void DeleteObject() {
+    // Adds or takes back a batch of strong references at once.
+    // The caller must keep at least one reference alive.
+    void TransferStrong(int delta) {
+        word_.fetch_add(static_cast<uint64_t>(int64_t{delta}), std::memory_order_acq_rel);
     }
 
 protected:
-    int strong_counter_ = 0;
-    int weak_counter_ = 0;
+    constexpr explicit AtomicCounting(uint64_t word) : word_(word) {
+    }
+
+    static constexpr int kWeakShift = 32;
+    static constexpr uint64_t kOneStrong = 1;
+    static constexpr uint64_t kOneWeak = uint64_t{1} << kWeakShift;
+    static constexpr uint64_t kStrongMask = kOneWeak - 1;
+
+    std::atomic<uint64_t> word_ = kOneStrong + kOneWeak;
+};
+
+// `AtomicCounting` that also supports immortal blocks (see `ImmortalShared`). Immortal blocks
+// are marked by the top bit of the strong half: every update loads the word first and skips
+// the write if it is set, so the line stays shared between cores. Mortal blocks pay that load
+// and branch on every update, which is why plain `AtomicCounting` does without.
+class ImmortalAtomicCounting : public AtomicCounting {
+public:
+    ImmortalAtomicCounting() = default;
+    constexpr explicit ImmortalAtomicCounting(ImmortalTag) : AtomicCounting(kImmortal) {
+    }
+
+    void IncStrong() {
+        if (!IsImmortal()) {
+            AtomicCounting::IncStrong();
+        }
+    }
+    bool TryIncStrong() {
+        return IsImmortal() || AtomicCounting::TryIncStrong();
+    }
+    bool DecStrong() {
+        return !IsImmortal() && AtomicCounting::DecStrong();
+    }
+    void IncWeak() {
+        if (!IsImmortal()) {
+            AtomicCounting::IncWeak();
+        }
+    }
+    bool DecWeak() {
+        return !IsImmortal() && AtomicCounting::DecWeak();
+    }
+    void TransferStrong(int delta) {
+        if (!IsImmortal()) {
+            AtomicCounting::TransferStrong(delta);
+        }
+    }
+    bool IsImmortal() const {
+        return (word_.load(std::memory_order_relaxed) & kImmortalBit) != 0;
+    }
+
+private:
+    static constexpr uint64_t kImmortalBit = uint64_t{1} << (kWeakShift - 1);
+    static constexpr uint64_t kImmortal = kImmortalBit | (kImmortalBit << kWeakShift);
 };
 
+// Biased reference counting: the thread that creates the block owns a plain counter, all
+// other threads share an atomic one. The object is alive while their sum is positive.
+//
+// The owner merges its counter into the shared one (and from then on uses the shared one too)
+// when its counter drops to zero. If other threads drop references the owner handed out, the
+// shared counter goes negative; the block is then queued to the owner, which merges it at its
+// next release or at `MergePending`. Blocks of an exited owner are merged by the thread that
+// finds its queue closed.
+// The owner's counter is an atomic updated with plain loads and stores, so other threads may
+// read it: before the merge, a negative shared counter is resolved by adding the two.
+class BiasedCounting {
+public:
+    BiasedCounting() : home_(CurrentQueue()) {
+        if (home_ == nullptr) {
+            shared_.store(kOne | kMerged, std::memory_order_relaxed);
+            owner_merged_ = true;
+            biased_.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void IncStrong() {
+        if (IsOwner()) {
+            AddBiased(1);
+        } else {
+            shared_.fetch_add(kOne, std::memory_order_relaxed);
+        }
+    }
+    bool TryIncStrong() {
+        if (IsOwner()) {
+            if (Biased() + Count(shared_.load(std::memory_order_acquire)) <= 0) {
+                return false;
+            }
+            AddBiased(1);
+            return true;
+        }
+        // Before the merge the object is alive while the two counters add up to more than zero.
+        // The acquire load makes the owner's counter at least as recent as every owner
+        // reference whose drop elsewhere made the shared counter negative. An unmerged block is
+        // never disposed and the merge changes the word, so a stale (higher) owner counter only
+        // lets the increment win a race with a concurrent release.
+        int64_t word = shared_.load(std::memory_order_acquire);
+        while (true) {
+            if (word & kMerged) {
+                if (Count(word) <= 0) {
+                    return false;
+                }
+            } else if (biased_.load(std::memory_order_acquire) + Count(word) <= 0) {
+                // The owner's counter may have been zeroed by a merge this word predates.
+                int64_t fresh = shared_.load(std::memory_order_acquire);
+                if (fresh == word) {
+                    return false;
+                }
+                word = fresh;
+                continue;
+            }
+            if (shared_.compare_exchange_weak(word, word + kOne, std::memory_order_acquire,
+                                              std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+    template <typename Block>
+    bool DecStrong(Block* block) {
+        if (IsOwner()) {
+            AddBiased(-1);
+            bool last = Biased() == 0 && Merge();
+            // May dispose this block: do not touch it afterwards.
+            if (home_->head.load(std::memory_order_relaxed) != nullptr) {
+                ProcessQueue(home_);
+            }
+            return last;
+        }
+        // The thread that drives the counter negative queues the block. It takes a weak
+        // reference first: once the decrement is visible the owner may free the object.
+        bool holds_weak = false;
+        int64_t word = shared_.load(std::memory_order_relaxed);
+        while (!(word & kMerged)) {
+            bool request = Count(word) <= 0 && !(word & kQueued);
+            if (request && !holds_weak) {
+                IncWeak();
+                holds_weak = true;
+            }
+            int64_t next = (word - kOne) | (request ? kQueued : 0);
+            if (shared_.compare_exchange_weak(word, next, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+                if (request) {
+                    return RequestMerge(block);
+                }
+                break;
+            }
+        }
+        if (holds_weak) {
+            weak_counter_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (!(word & kMerged)) {
+            return false;
+        }
+        return Count(shared_.fetch_sub(kOne, std::memory_order_acq_rel) - kOne) == 0;
+    }
+    void IncWeak() {
+        weak_counter_.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool DecWeak() {
+        if (weak_counter_.load(std::memory_order_acquire) == 1) {
+            return true;
+        }
+        return weak_counter_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    // Exact on the owner thread; elsewhere, before the merge, it may miss concurrent updates.
+    size_t StrongCount() const {
+        int64_t word = shared_.load(std::memory_order_acquire);
+        if (word & kMerged) {
+            return Count(word);
+        }
+        return std::max<int64_t>(Biased() + Count(word), 0);
+    }
+
+    // Merges the blocks queued to the calling thread. Long-lived owners that rarely
+    // release may call it at quiet points.
+    static void MergePending() {
+        if (tls_queue != nullptr) {
+            ProcessQueue(tls_queue);
+        }
+    }
+
+private:
+    struct MergeRequest {
+        MergeRequest* next;
+        void* block;
+        void (*merge)(void* block);
+    };
+
+    // Never freed or reused: its address identifies the owner thread.
+    struct OwnerQueue {
+        std::atomic<MergeRequest*> head = nullptr;
+        OwnerQueue* next = nullptr;
+    };
+
+    // Closes the queue of an exiting thread.
+    struct QueueGuard {
+        ~QueueGuard() {
+            OwnerQueue* queue = std::exchange(tls_queue, nullptr);
+            tls_exited = true;
+            TakeAndMerge(queue->head.exchange(&closed_marker, std::memory_order_acq_rel));
+        }
+    };
+
+    // The shared word: count << 2 | queued | merged.
+    static constexpr int64_t kMerged = 1;
+    static constexpr int64_t kQueued = 2;
+    static constexpr int64_t kOne = 4;
+
+    static int64_t Count(int64_t word) {
+        return word >> 2;
+    }
+
+    static OwnerQueue* CurrentQueue() {
+        if (tls_queue == nullptr && !tls_exited) {
+            tls_queue = new OwnerQueue;
+            tls_queue->next = all_queues.load(std::memory_order_relaxed);
+            while (!all_queues.compare_exchange_weak(tls_queue->next, tls_queue,
+                                                     std::memory_order_relaxed)) {
+            }
+            thread_local QueueGuard guard;
+        }
+        return tls_queue;
+    }
+
+    bool IsOwner() const {
+        return home_ == tls_queue && !owner_merged_;
+    }
+
+    // Written by the owner only, so a relaxed load and store do instead of a read-modify-write.
+    int Biased() const {
+        return biased_.load(std::memory_order_relaxed);
+    }
+    void AddBiased(int delta) {
+        biased_.store(Biased() + delta, std::memory_order_relaxed);
+    }
+
+    // Adds the owner's counter to the shared one; returns true if nothing is left.
+    bool Merge() {
+        owner_merged_ = true;
+        int64_t delta = Biased() * kOne + kMerged;
+        int64_t word = shared_.fetch_add(delta, std::memory_order_acq_rel) + delta;
+        // After the merged word: a thread that reads the zero also sees the merge.
+        biased_.store(0, std::memory_order_release);
+        return Count(word) == 0;
+    }
+
+    // Called with the queued flag set and a weak reference taken, which the request keeps.
+    template <typename Block>
+    bool RequestMerge(Block* block) {
+        auto* request = new MergeRequest{nullptr, block, &MergeQueued<Block>};
+        MergeRequest* head = home_->head.load(std::memory_order_acquire);
+        while (head != &closed_marker) {
+            request->next = head;
+            if (home_->head.compare_exchange_weak(head, request, std::memory_order_release,
+                                                  std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        // The owner has exited, so its counter no longer changes.
+        delete request;
+        weak_counter_.fetch_sub(1, std::memory_order_relaxed);
+        return Merge();
+    }
+
+    template <typename Block>
+    static void MergeQueued(void* ptr) {
+        auto* block = static_cast<Block*>(ptr);
+        if (!block->GetCounting().owner_merged_ && block->GetCounting().Merge()) {
+            block->DisposeLastStrong();
+        }
+        block->ReleaseWeak();
+    }
+
+    static void ProcessQueue(OwnerQueue* queue) {
+        TakeAndMerge(queue->head.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    static void TakeAndMerge(MergeRequest* request) {
+        while (request != nullptr) {
+            MergeRequest* next = request->next;
+            request->merge(request->block);
+            delete request;
+            request = next;
+        }
+    }
+
+    OwnerQueue* const home_;
+    std::atomic<int> biased_ = 1;
+    bool owner_merged_ = false;
+    std::atomic<int64_t> shared_ = 0;
+    std::atomic<int> weak_counter_ = 1;
+
+    static inline MergeRequest closed_marker{};
+    static inline std::atomic<OwnerQueue*> all_queues = nullptr;
+    static inline thread_local OwnerQueue* tls_queue = nullptr;
+    static inline thread_local bool tls_exited = false;
+};
+
+// Allocator for the control blocks of `SharedPtr(T*)` and `MakeShared`.
+// A counting policy may override it with a nested `BlockAllocator` template.
+template <typename Counting, typename T, typename = void>
+struct DefaultBlockAllocatorTraits {
+    using Type = std::allocator<T>;
+};
+
+template <typename Counting, typename T>
+struct DefaultBlockAllocatorTraits<Counting, T,
+                                   std::void_t<typename Counting::template BlockAllocator<T>>> {
+    using Type = typename Counting::template BlockAllocator<T>;
+};
+
+template <typename Counting, typename T>
+using DefaultBlockAllocator = typename DefaultBlockAllocatorTraits<Counting, T>::Type;
+
+// A counting policy may take over disposal (destroying the object and dropping the
+// weak reference of the strong owners) with a static `Dispose(Block*)`.
+template <typename Counting, typename Block, typename = void>
+struct HasCustomDisposal : std::false_type {};
+
+template <typename Counting, typename Block>
+struct HasCustomDisposal<Counting, Block,
+                         std::void_t<decltype(Counting::Dispose(std::declval<Block*>()))>>
+    : std::true_type {};
+
+// A counting policy that may hand the block to another thread takes it in `DecStrong(Block*)`.
+template <typename Counting, typename Block, typename = void>
+struct DecStrongTakesBlock : std::false_type {};
+
+template <typename Counting, typename Block>
+struct DecStrongTakesBlock<
+    Counting, Block,
+    std::void_t<decltype(std::declval<Counting&>().DecStrong(std::declval<Block*>()))>>
+    : std::true_type {};
+
+// Identifies a type without RTTI: one address per type.
 template <typename T>
-class ControlBlockForExistedObject : public ControlBlock {
+const void* TypeTag() {
+    static constexpr char kTag = 0;
+    return &kTag;
+}
+
+// Counters live in the base and are reached directly. The only type-erased
+// operations are destroying the object and freeing the block; they are
+// dispatched through one static table per block type instead of a vtable.
+template <typename Counting>
+class ControlBlock {
 public:
-    ControlBlockForExistedObject() {
-        strong_counter_ = 1;
+    struct Ops {
+        void (*destroy_object)(ControlBlock* block);
+        void (*deallocate)(ControlBlock* block);
+        // Only blocks that hold a deleter set it.
+        void* (*get_deleter)(ControlBlock* block, const void* type) = nullptr;
+    };
+
+    explicit ControlBlock(const Ops* ops) : ops_(ops) {
+    }
+    // The counters never reach zero, so `ops` is never called.
+    constexpr ControlBlock(const Ops* ops, ImmortalTag tag) : ops_(ops), counting_(tag) {
+    }
+
+    ControlBlock(const ControlBlock&) = delete;
+    ControlBlock& operator=(const ControlBlock&) = delete;
+
+    Counting& GetCounting() {
+        return counting_;
+    }
+    // Identifies the concrete block type.
+    const Ops* GetOps() const {
+        return ops_;
+    }
+    void DeleteObject() {
+        ops_->destroy_object(this);
+    }
+    // The stored deleter if its type is identified by `type` (see `TypeTag`), else nullptr.
+    void* GetDeleter(const void* type) {
+        return ops_->get_deleter == nullptr ? nullptr : ops_->get_deleter(this, type);
     }
 
-    ControlBlockForExistedObject(T* ptr) {
-        object_ = ptr;
-        strong_counter_ = 1;
+    void ReleaseStrong() {
+        bool last;
+        if constexpr (DecStrongTakesBlock<Counting, ControlBlock>::value) {
+            last = counting_.DecStrong(this);
+        } else {
+            last = counting_.DecStrong();
+        }
+        if (last) {
+            DisposeLastStrong();
+        }
+    }
+    // Disposes through the policy if it takes over disposal.
+    void DisposeLastStrong() {
+        if constexpr (HasCustomDisposal<Counting, ControlBlock>::value) {
+            Counting::Dispose(this);
+        } else {
+            Dispose();
+        }
+    }
+    // Called once the last strong reference is gone.
+    void Dispose() {
+        DeleteObject();
+        ReleaseWeak();
+    }
+    void ReleaseWeak() {
+        if (counting_.DecWeak()) {
+            ops_->deallocate(this);
+        }
     }
 
-    int& GetStrongCounter() override {
-        return strong_counter_;
+protected:
+    ~ControlBlock() = default;
+
+private:
+    const Ops* ops_;
+    Counting counting_;
+};
+
+// Allocates `Block` with `alloc` rebound to it and constructs it from `args`.
+// The block keeps a copy of the allocator and frees itself with it.
+template <typename Block, typename Alloc, typename... Args>
+Block* AllocateControlBlock(const Alloc& alloc, Args&&... args) {
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+    BlockAlloc block_alloc(alloc);
+    Block* block = std::allocator_traits<BlockAlloc>::allocate(block_alloc, 1);
+    try {
+        ::new (static_cast<void*>(block)) Block(std::forward<Args>(args)...);
+    } catch (...) {
+        std::allocator_traits<BlockAlloc>::deallocate(block_alloc, block, 1);
+        throw;
     }
-    int& GetWeakCounter() override {
-        return weak_counter_;
+    return block;
+}
+
+template <typename T, typename Counting, typename Deleter = std::default_delete<T>,
+          typename Alloc = std::allocator<T>>
+class ControlBlockForExistedObject : public ControlBlock<Counting> {
+    using Base = ControlBlock<Counting>;
+    using BlockAlloc =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<ControlBlockForExistedObject>;
+
+public:
+    ControlBlockForExistedObject(T* ptr, Deleter deleter = Deleter(), const Alloc& alloc = Alloc())
+        : Base(&kOps), object_(ptr), deleter_and_alloc_(std::move(deleter), BlockAlloc(alloc)) {
     }
+
     T* GetObject() {
         return object_;
     }
-    void DeleteObject() override {
-        delete object_;
+
+private:
+    static void DestroyObject(Base* base) {
+        auto* block = static_cast<ControlBlockForExistedObject*>(base);
+        block->deleter_and_alloc_.GetFirst()(block->object_);
     }
-    ~ControlBlockForExistedObject() override {
-        //        delete object_;
+    static void Deallocate(Base* base) {
+        auto* block = static_cast<ControlBlockForExistedObject*>(base);
+        BlockAlloc alloc(std::move(block->deleter_and_alloc_.GetSecond()));
+        block->~ControlBlockForExistedObject();
+        std::allocator_traits<BlockAlloc>::deallocate(alloc, block, 1);
+    }
+    static void* GetDeleterOf(Base* base, const void* type) {
+        if (type != TypeTag<Deleter>()) {
+            return nullptr;
+        }
+        return &static_cast<ControlBlockForExistedObject*>(base)->deleter_and_alloc_.GetFirst();
     }
 
-private:
+    static constexpr typename Base::Ops kOps{&DestroyObject, &Deallocate, &GetDeleterOf};
+
     T* object_;
+    // An empty deleter (and allocator) takes no space.
+    CompressedPair<Deleter, BlockAlloc> deleter_and_alloc_;
 };
 
-template <typename T>
-class ControlBlockForNewObject : public ControlBlock {
+// The object lives inside the block: one allocation for both.
+template <typename T, typename Counting, typename Alloc = std::allocator<T>>
+class ControlBlockForNewObject : public ControlBlock<Counting> {
+    using Base = ControlBlock<Counting>;
+    using BlockAlloc =
+        typename std::allocator_traits<Alloc>::template rebind_alloc<ControlBlockForNewObject>;
+    using Storage = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
 public:
-    ControlBlockForNewObject() {
-        strong_counter_ = 1;
-        weak_counter_ = 0;
-        ::new (&memory_block_) T();
-    };
     template <typename... Args>
-    ControlBlockForNewObject(Args&&... args) {
-        strong_counter_ = 1;
-        ::new (&memory_block_) T(std::forward<Args>(args)...);
+    ControlBlockForNewObject(const Alloc& alloc, Args&&... args)
+        : Base(&kOps), alloc_and_memory_(BlockAlloc(alloc)) {
+        ::new (&alloc_and_memory_.GetSecond()) T(std::forward<Args>(args)...);
     }
     T* GetObject() {
-        return reinterpret_cast<T*>(&memory_block_);
+        return reinterpret_cast<T*>(&alloc_and_memory_.GetSecond());
     }
-    int& GetStrongCounter() override {
-        return strong_counter_;
+
+    static bool IsInstance(const Base* block) {
+        return block->GetOps() == &kOps;
+    }
+
+private:
+    static void DestroyObject(Base* block) {
+        static_cast<ControlBlockForNewObject*>(block)->GetObject()->~T();
     }
-    int& GetWeakCounter() override {
-        return weak_counter_;
+    static void Deallocate(Base* base) {
+        auto* block = static_cast<ControlBlockForNewObject*>(base);
+        BlockAlloc alloc(std::move(block->alloc_and_memory_.GetFirst()));
+        block->~ControlBlockForNewObject();
+        std::allocator_traits<BlockAlloc>::deallocate(alloc, block, 1);
     }
-    void DeleteObject() override {
-        if (GetObject() != nullptr) {
-            GetObject()->~T();
+
+    static constexpr typename Base::Ops kOps{&DestroyObject, &Deallocate};
+
+    CompressedPair<BlockAlloc, Storage> alloc_and_memory_;
+};
+
+// `size` elements follow the block in the same allocation. They start on their own cache line,
+// so readers of the data do not share a line with the counters.
+template <typename T, typename Counting, typename Alloc = std::allocator<T>>
+class ControlBlockForNewArray : public ControlBlock<Counting> {
+    using Base = ControlBlock<Counting>;
+
+    static constexpr size_t kCacheLine = 64;
+    struct alignas(kCacheLine) Line {
+        std::byte bytes[kCacheLine];
+    };
+    using LineAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Line>;
+
+    static_assert(alignof(T) <= kCacheLine);
+
+public:
+    // Elements are value-initialized, or default-initialized (left indeterminate for
+    // trivial types) if `for_overwrite` is set.
+    // Throws `std::bad_array_new_length` if the block size does not fit in `size_t`.
+    static ControlBlockForNewArray* Create(const Alloc& alloc, size_t size, bool for_overwrite) {
+        if (size > (std::numeric_limits<size_t>::max() - DataOffset() - kCacheLine) / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        LineAlloc line_alloc(alloc);
+        Line* lines = std::allocator_traits<LineAlloc>::allocate(line_alloc, NumLines(size));
+        auto* block = ::new (static_cast<void*>(lines)) ControlBlockForNewArray(alloc, size);
+        T* data = block->GetObject();
+        size_t constructed = 0;
+        try {
+            for (; constructed < size; ++constructed) {
+                if (for_overwrite) {
+                    ::new (static_cast<void*>(data + constructed)) T;
+                } else {
+                    ::new (static_cast<void*>(data + constructed)) T();
+                }
+            }
+        } catch (...) {
+            block->alloc_and_size_.GetSecond() = constructed;
+            DestroyObject(block);
+            Deallocate(block);
+            throw;
         }
+        return block;
+    }
+
+    T* GetObject() {
+        return reinterpret_cast<T*>(reinterpret_cast<std::byte*>(this) + DataOffset());
     }
-    ~ControlBlockForNewObject() {
-        //        if (GetObject() != nullptr) {
-        //            GetObject()->~T();
-        //        }
+    size_t Size() const {
+        return alloc_and_size_.GetSecond();
     }
 
 private:
-    std::aligned_storage_t<sizeof(T), alignof(T)> memory_block_;
+    ControlBlockForNewArray(const Alloc& alloc, size_t size)
+        : Base(&kOps), alloc_and_size_(LineAlloc(alloc), size) {
+    }
+
+    static constexpr size_t DataOffset() {
+        return (sizeof(ControlBlockForNewArray) + kCacheLine - 1) / kCacheLine * kCacheLine;
+    }
+    static constexpr size_t NumLines(size_t size) {
+        return (DataOffset() + size * sizeof(T) + kCacheLine - 1) / kCacheLine;
+    }
+
+    static void DestroyObject(Base* base) {
+        auto* block = static_cast<ControlBlockForNewArray*>(base);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            T* data = block->GetObject();
+            for (size_t i = block->Size(); i > 0; --i) {
+                data[i - 1].~T();
+            }
+        }
+    }
+    static void Deallocate(Base* base) {
+        auto* block = static_cast<ControlBlockForNewArray*>(base);
+        LineAlloc alloc(std::move(block->alloc_and_size_.GetFirst()));
+        size_t num_lines = NumLines(block->Size());
+        block->~ControlBlockForNewArray();
+        std::allocator_traits<LineAlloc>::deallocate(alloc, reinterpret_cast<Line*>(block),
+                                                     num_lines);
+    }
+
+    static constexpr typename Base::Ops kOps{&DestroyObject, &Deallocate};
+
+    CompressedPair<LineAlloc, size_t> alloc_and_size_;
 };
 
-template <typename T>
+template <typename T, typename Counting = SingleThreadedCounting>
 class SharedPtr;
 
-template <typename T>
+template <typename T, typename Counting = SingleThreadedCounting>
 class WeakPtr;
+
+template <typename T>
+class AtomicSharedPtr;
+
+template <typename T, typename Counting>
+class ThinSharedPtr;
+
+template <typename T>
+class ShardedSharedPtr;
+
+template <typename T>
+class HazardSharedPtr;
+
+template <typename T>
+class RcuCell;
+
+template <typename T, typename Counting>
+class ImmortalShared;
+
+template <typename T, typename Counting = SingleThreadedCounting>
+class BorrowedShared;
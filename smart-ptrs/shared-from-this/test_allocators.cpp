@@ -0,0 +1,166 @@
+#include "shared.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <common/my_int.h>
+
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct AllocatorStats {
+    int allocations = 0;
+    int deallocations = 0;
+};
+
+template <typename T>
+class CountingAllocator {
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(AllocatorStats* stats) : stats_(stats) {
+    }
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) : stats_(other.GetStats()) {
+    }
+
+    T* allocate(size_t n) {
+        ++stats_->allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        ++stats_->deallocations;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    AllocatorStats* GetStats() const {
+        return stats_;
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const {
+        return stats_ == other.GetStats();
+    }
+
+private:
+    AllocatorStats* stats_;
+};
+
+struct Tracked : EnableSharedFromThis<Tracked> {
+    Tracked(int value) : value(value) {
+    }
+
+    int value;
+};
+
+TEST_CASE("AllocateShared") {
+    SECTION("One allocation from the allocator") {
+        AllocatorStats stats;
+        EXPECT_ONE_ALLOCATION({
+            auto sp = AllocateShared<MyInt>(CountingAllocator<MyInt>(&stats), 42);
+            REQUIRE(*sp == 42);
+            REQUIRE(stats.allocations == 1);
+        });
+        REQUIRE(stats.deallocations == 1);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Block is freed with the allocator after the last weak reference") {
+        AllocatorStats stats;
+        WeakPtr<MyInt> weak;
+        {
+            auto sp = AllocateShared<MyInt>(CountingAllocator<MyInt>(&stats), 7);
+            weak = sp;
+        }
+        REQUIRE(weak.Expired());
+        REQUIRE(MyInt::AliveCount() == 0);
+        REQUIRE(stats.deallocations == 0);
+        weak.Reset();
+        REQUIRE(stats.deallocations == 1);
+    }
+
+    SECTION("Atomic counting and SharedFromThis") {
+        AllocatorStats stats;
+        {
+            auto sp = AllocateShared<Tracked>(CountingAllocator<Tracked>(&stats), 5);
+            REQUIRE(sp->SharedFromThis() == sp);
+            auto atomic = AllocateShared<int, AtomicCounting>(CountingAllocator<int>(&stats), 1);
+            REQUIRE(*atomic == 1);
+        }
+        REQUIRE(stats.allocations == 2);
+        REQUIRE(stats.deallocations == 2);
+    }
+
+    SECTION("Stateless allocators take no space") {
+        static_assert(sizeof(ControlBlockForNewObject<int64_t, SingleThreadedCounting>) ==
+                      sizeof(void*) + sizeof(SingleThreadedCounting) + sizeof(int64_t));
+    }
+}
+
+TEST_CASE("SharedPtr with deleter and allocator") {
+    AllocatorStats stats;
+    int deleted = 0;
+    auto deleter = [&deleted](MyInt* ptr) {
+        ++deleted;
+        delete ptr;
+    };
+    {
+        SharedPtr<MyInt> sp(new MyInt(3), deleter, CountingAllocator<MyInt>(&stats));
+        SharedPtr<MyInt> copy = sp;
+        REQUIRE(stats.allocations == 1);
+        REQUIRE(*copy == 3);
+    }
+    REQUIRE(deleted == 1);
+    REQUIRE(stats.deallocations == 1);
+    REQUIRE(MyInt::AliveCount() == 0);
+}
+
+TEST_CASE("Custom deleters") {
+    SECTION("Empty deleters take no space") {
+        struct Empty {
+            void operator()(MyInt* ptr) const {
+                delete ptr;
+            }
+        };
+        static_assert(sizeof(ControlBlockForExistedObject<MyInt, SingleThreadedCounting, Empty>) ==
+                      sizeof(ControlBlockForExistedObject<MyInt, SingleThreadedCounting>));
+
+        SharedPtr<MyInt> sp(new MyInt(1), Empty());
+        REQUIRE(sp.GetDeleter<Empty>() != nullptr);
+        REQUIRE(sp.GetDeleter<std::default_delete<MyInt>>() == nullptr);
+    }
+
+    SECTION("Stateful deleters are reachable") {
+        struct Closer {
+            int* closed;
+            void operator()(int* handle) const {
+                ++*closed;
+                delete handle;
+            }
+        };
+        int closed = 0;
+        {
+            SharedPtr<int, AtomicCounting> handle(new int(7), Closer{&closed});
+            auto copy = handle;
+            Closer* closer = copy.GetDeleter<Closer>();
+            REQUIRE(closer != nullptr);
+            REQUIRE(closer->closed == &closed);
+            REQUIRE(closed == 0);
+        }
+        REQUIRE(closed == 1);
+    }
+
+    SECTION("Default deleters and made objects") {
+        SharedPtr<MyInt> adopted(new MyInt(2));
+        REQUIRE(adopted.GetDeleter<std::default_delete<MyInt>>() != nullptr);
+        REQUIRE(MakeShared<MyInt>(3).GetDeleter<std::default_delete<MyInt>>() == nullptr);
+        REQUIRE(SharedPtr<MyInt>().GetDeleter<std::default_delete<MyInt>>() == nullptr);
+    }
+
+    REQUIRE(MyInt::AliveCount() == 0);
+}
@@ -0,0 +1,97 @@
+#include "shared.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <common/my_int.h>
+
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("MakeShared for arrays") {
+    SECTION("Unbounded") {
+        SharedPtr<int[]> ints;
+        EXPECT_ONE_ALLOCATION(ints = MakeShared<int[]>(100););
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(ints[i] == 0);
+        }
+        REQUIRE(reinterpret_cast<uintptr_t>(ints.Get()) % 64 == 0);
+    }
+
+    SECTION("Bounded") {
+        auto ints = MakeShared<int[4]>();
+        ints[3] = 7;
+        REQUIRE(ints[0] == 0);
+        REQUIRE(ints.Get()[3] == 7);
+    }
+
+    SECTION("Elements are destroyed with the last owner") {
+        auto ptr = MakeShared<MyInt[], AtomicCounting>(5);
+        REQUIRE(MyInt::AliveCount() == 5);
+        WeakPtr<MyInt[], AtomicCounting> weak = ptr;
+        auto copy = weak.Lock();
+        ptr.Reset();
+        REQUIRE(MyInt::AliveCount() == 5);
+        copy.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Empty array") {
+        auto ptr = MakeShared<MyInt[]>(0);
+        REQUIRE(ptr);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("For overwrite") {
+        SharedPtr<char[]> buffer;
+        EXPECT_ONE_ALLOCATION(buffer = MakeSharedForOverwrite<char[]>(1 << 20););
+        buffer[(1 << 20) - 1] = 'x';
+        REQUIRE(buffer[(1 << 20) - 1] == 'x');
+
+        auto fixed = MakeSharedForOverwrite<MyInt[3]>();
+        REQUIRE(MyInt::AliveCount() == 3);
+    }
+}
+
+struct ThrowsOnThird {
+    ThrowsOnThird() {
+        if (++constructed == 3) {
+            throw std::runtime_error("third");
+        }
+        ++alive;
+    }
+    ~ThrowsOnThird() {
+        --alive;
+    }
+
+    static inline int constructed = 0;
+    static inline int alive = 0;
+};
+
+TEST_CASE("Array construction failure") {
+    REQUIRE_THROWS_AS(MakeShared<ThrowsOnThird[]>(5), std::runtime_error);
+    REQUIRE(ThrowsOnThird::alive == 0);
+
+    // The block size would wrap around: nothing is allocated or constructed.
+    int constructed = ThrowsOnThird::constructed;
+    EXPECT_ZERO_ALLOCATIONS(
+        REQUIRE_THROWS_AS(MakeShared<int[]>(SIZE_MAX / 2), std::bad_array_new_length);
+        REQUIRE_THROWS_AS(MakeShared<ThrowsOnThird[]>(SIZE_MAX / sizeof(ThrowsOnThird)),
+                          std::bad_array_new_length););
+    REQUIRE(ThrowsOnThird::constructed == constructed);
+}
+
+TEST_CASE("Adopting arrays") {
+    SharedPtr<MyInt[]> ptr(new MyInt[3]);
+    REQUIRE(MyInt::AliveCount() == 3);
+    ptr.Reset(new MyInt[2]);
+    REQUIRE(MyInt::AliveCount() == 2);
+    ptr.Reset();
+    REQUIRE(MyInt::AliveCount() == 0);
+}
@@ -0,0 +1,148 @@
+#include "atomic_shared.h"
+
+#include <catch.hpp>
+
+#include <common/my_int.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("AtomicSharedPtr basics") {
+    SECTION("Empty") {
+        AtomicSharedPtr<int> atomic;
+        REQUIRE(!atomic.Load());
+        REQUIRE(atomic.IsLockFree());
+    }
+
+    SECTION("Load and store") {
+        auto value = MakeShared<MyInt, AtomicCounting>(1);
+        AtomicSharedPtr<MyInt> atomic(value);
+        REQUIRE(value.UseCount() == 2);
+        REQUIRE(*atomic.Load() == 1);
+        REQUIRE(atomic.Load().Get() == value.Get());
+
+        atomic.Store(MakeShared<MyInt, AtomicCounting>(2));
+        REQUIRE(value.UseCount() == 1);
+        REQUIRE(*atomic.Load() == 2);
+        REQUIRE(MyInt::AliveCount() == 2);
+
+        atomic.Store(nullptr);
+        REQUIRE(!atomic.Load());
+        REQUIRE(MyInt::AliveCount() == 1);
+    }
+
+    SECTION("Loaded pointers outlive the store") {
+        AtomicSharedPtr<MyInt> atomic(MakeShared<MyInt, AtomicCounting>(3));
+        auto loaded = atomic.Load();
+        atomic.Store(nullptr);
+        REQUIRE(*loaded == 3);
+        REQUIRE(MyInt::AliveCount() == 1);
+        loaded.Reset();
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Exchange") {
+        auto first = MakeShared<MyInt, AtomicCounting>(1);
+        AtomicSharedPtr<MyInt> atomic(first);
+        auto old = atomic.Exchange(MakeShared<MyInt, AtomicCounting>(2));
+        REQUIRE(old.Get() == first.Get());
+        REQUIRE(*atomic.Load() == 2);
+    }
+
+    SECTION("Compare exchange") {
+        auto first = MakeShared<MyInt, AtomicCounting>(1);
+        AtomicSharedPtr<MyInt> atomic(first);
+
+        auto other = MakeShared<MyInt, AtomicCounting>(7);
+        auto expected = other;
+        REQUIRE(!atomic.CompareExchange(expected, MakeShared<MyInt, AtomicCounting>(2)));
+        REQUIRE(expected.Get() == first.Get());
+
+        // Both the stored pointer and a loaded one are accepted.
+        REQUIRE(atomic.CompareExchange(first, MakeShared<MyInt, AtomicCounting>(2)));
+        auto loaded = atomic.Load();
+        REQUIRE(atomic.CompareExchange(loaded, MakeShared<MyInt, AtomicCounting>(3)));
+        REQUIRE(*atomic.Load() == 3);
+        REQUIRE(MyInt::AliveCount() == 4);
+    }
+
+    REQUIRE(MyInt::AliveCount() == 0);
+}
+
+TEST_CASE("AtomicSharedPtr refills prepaid references") {
+    AtomicSharedPtr<MyInt> atomic(MakeShared<MyInt, AtomicCounting>(5));
+    std::vector<SharedPtr<MyInt, AtomicCounting>> loaded;
+    for (int i = 0; i < 200000; ++i) {
+        loaded.push_back(atomic.Load());
+    }
+    atomic.Store(nullptr);
+    REQUIRE(MyInt::AliveCount() == 1);
+    loaded.clear();
+    REQUIRE(MyInt::AliveCount() == 0);
+}
+
+// `MyInt` counts instances without synchronization.
+struct Published {
+    explicit Published(int value) : value(value) {
+        alive.fetch_add(1);
+    }
+    ~Published() {
+        alive.fetch_sub(1);
+    }
+    int value;
+    static inline std::atomic<int> alive = 0;
+};
+
+TEST_CASE("AtomicSharedPtr across threads") {
+    constexpr int kReaders = 6;
+    constexpr int kWriters = 2;
+    constexpr int kIterations = 20000;
+
+    AtomicSharedPtr<Published> atomic(MakeShared<Published, AtomicCounting>(0));
+    std::atomic<bool> start = false;
+    std::atomic<int> bad_reads = 0;
+    std::atomic<int> swaps = 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kReaders; ++i) {
+        threads.emplace_back([&] {
+            while (!start.load()) {
+            }
+            for (int j = 0; j < kIterations; ++j) {
+                auto value = atomic.Load();
+                if (!value || value->value < 0) {
+                    bad_reads.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kWriters; ++i) {
+        threads.emplace_back([&, i] {
+            while (!start.load()) {
+            }
+            for (int j = 0; j < kIterations / 10; ++j) {
+                if (j % 2 == 0) {
+                    atomic.Store(MakeShared<Published, AtomicCounting>(i));
+                    continue;
+                }
+                auto expected = atomic.Load();
+                if (atomic.CompareExchange(expected, MakeShared<Published, AtomicCounting>(j))) {
+                    swaps.fetch_add(1);
+                }
+            }
+        });
+    }
+    start = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(bad_reads.load() == 0);
+    REQUIRE(swaps.load() > 0);
+    REQUIRE(Published::alive.load() == 1);
+    atomic.Store(nullptr);
+    REQUIRE(Published::alive.load() == 0);
+}
@@ -0,0 +1,82 @@
+#include "borrowed.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Widget {
+    int value = 1;
+};
+
+struct NamedWidget : Widget {
+    std::string name = "named";
+};
+
+static int Value(BorrowedShared<Widget, AtomicCounting> object) {
+    return object ? object->value : 0;
+}
+
+TEST_CASE("Detach and adopt") {
+    SECTION("Round trip") {
+        auto sp = MakeShared<std::string>("text");
+        auto detached = sp.Detach();
+        REQUIRE(!sp);
+        REQUIRE(*detached.pointer == "text");
+
+        auto back = SharedPtr<std::string>::Adopt(detached);
+        REQUIRE(back.UseCount() == 1);
+        REQUIRE(*back == "text");
+    }
+
+    SECTION("Weak pointers see the detached reference") {
+        auto sp = MakeShared<int, AtomicCounting>(5);
+        WeakPtr<int, AtomicCounting> weak(sp);
+        auto detached = sp.Detach();
+        REQUIRE(!weak.Expired());
+        SharedPtr<int, AtomicCounting>::Adopt(detached).Reset();
+        REQUIRE(weak.Expired());
+    }
+
+    SECTION("Empty") {
+        SharedPtr<int> empty;
+        auto detached = empty.Detach();
+        REQUIRE(detached.block == nullptr);
+        REQUIRE(!SharedPtr<int>::Adopt(detached));
+    }
+}
+
+TEST_CASE("BorrowedShared") {
+    auto named = MakeShared<NamedWidget, AtomicCounting>();
+    SharedPtr<Widget, AtomicCounting> widget = named;
+
+    SECTION("No reference counting") {
+        REQUIRE(Value(widget) == 1);
+        REQUIRE(Value(named) == 1);
+        REQUIRE(Value(nullptr) == 0);
+        BorrowedShared<NamedWidget, AtomicCounting> view = named;
+        BorrowedShared<NamedWidget, AtomicCounting> copy = view;
+        REQUIRE(copy->name == "named");
+        REQUIRE((*view).value == 1);
+        REQUIRE(named.UseCount() == 2);
+        EXPECT_ZERO_ALLOCATIONS(REQUIRE(Value(named) == 1));
+    }
+
+    SECTION("Upgrade") {
+        SharedPtr<NamedWidget, AtomicCounting> owner;
+        {
+            BorrowedShared<NamedWidget, AtomicCounting> view = named;
+            owner = view.Upgrade();
+            REQUIRE(named.UseCount() == 3);
+        }
+        named.Reset();
+        widget.Reset();
+        REQUIRE(owner.UseCount() == 1);
+        REQUIRE(owner->name == "named");
+        REQUIRE(!BorrowedShared<int>(nullptr).Upgrade());
+    }
+}
@@ -0,0 +1,91 @@
+#include "buffer.h"
+
+#include <catch.hpp>
+
+#include <string>
+#include <string_view>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static SharedBuffer<> FromString(std::string_view text) {
+    return SharedBuffer<>::CopyFrom(text.data(), text.size());
+}
+
+static std::string ToString(const SharedBuffer<>& buffer) {
+    return std::string(reinterpret_cast<const char*>(buffer.Data()), buffer.Size());
+}
+
+static std::string ToString(const BufferChain<>& chain) {
+    std::string result(chain.Size(), '\0');
+    chain.CopyTo(reinterpret_cast<std::byte*>(result.data()));
+    return result;
+}
+
+TEST_CASE("SharedBuffer") {
+    SECTION("Slices share the allocation") {
+        auto buffer = FromString("header:payload");
+        auto header = buffer.Slice(0, 6);
+        auto payload = buffer.Slice(7, 7);
+        REQUIRE(ToString(header) == "header");
+        REQUIRE(ToString(payload) == "payload");
+        REQUIRE(payload.Data() == buffer.Data() + 7);
+        REQUIRE(buffer.UseCount() == 3);
+
+        buffer.Reset();
+        REQUIRE(payload.UseCount() == 2);
+        REQUIRE(ToString(payload.Slice(3, 4)) == "load");
+    }
+
+    SECTION("Split and trim") {
+        auto buffer = FromString("0123456789");
+        auto tail = buffer.Split(4);
+        REQUIRE(ToString(buffer) == "0123");
+        REQUIRE(ToString(tail) == "456789");
+
+        tail.RemovePrefix(1);
+        tail.RemoveSuffix(2);
+        REQUIRE(ToString(tail) == "567");
+        REQUIRE(tail[0] == std::byte{'5'});
+        REQUIRE(tail.UseCount() == 2);
+    }
+
+    SECTION("Moving a slice out takes no reference") {
+        auto buffer = FromString("abcdef");
+        auto moved = std::move(buffer).Slice(2, 3);
+        REQUIRE(ToString(moved) == "cde");
+        REQUIRE(moved.UseCount() == 1);
+        REQUIRE(buffer.Empty());
+        REQUIRE(buffer.Data() == nullptr);
+    }
+}
+
+TEST_CASE("BufferChain") {
+    BufferChain<> chain;
+    chain.Append(FromString("GET "));
+    chain.Append(FromString(""));
+    chain.Append(FromString("/index"));
+    chain.Append(FromString(".html\r\n"));
+    REQUIRE(chain.FragmentCount() == 3);
+    REQUIRE(chain.Size() == 17);
+    REQUIRE(ToString(chain) == "GET /index.html\r\n");
+
+    SECTION("Split across fragments") {
+        auto head = chain.Split(6);
+        REQUIRE(ToString(head) == "GET /i");
+        REQUIRE(head.FragmentCount() == 2);
+        REQUIRE(ToString(chain) == "ndex.html\r\n");
+        REQUIRE(chain.FragmentCount() == 2);
+
+        chain.RemovePrefix(9);
+        REQUIRE(ToString(chain) == "\r\n");
+        REQUIRE(chain.FragmentCount() == 1);
+    }
+
+    SECTION("Flatten") {
+        auto flat = chain.Flatten();
+        REQUIRE(ToString(flat) == "GET /index.html\r\n");
+
+        BufferChain<> single(flat.Slice(4, 6));
+        REQUIRE(single.Flatten().Data() == flat.Data() + 4);
+    }
+}
@@ -0,0 +1,107 @@
+#include "chain_writer.h"
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static SharedBuffer<> Fragment(std::string_view text) {
+    return SharedBuffer<>::CopyFrom(text.data(), text.size());
+}
+
+static std::string ReadAll(int fd, size_t size) {
+    std::string result(size, '\0');
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = read(fd, result.data() + done, size - done);
+        REQUIRE(got > 0);
+        done += got;
+    }
+    return result;
+}
+
+TEST_CASE("Gathered writes") {
+    SECTION("Many fragments in several batches") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        auto body = Fragment("0123456789");
+        BufferChain<> chain;
+        std::string expected;
+        for (int i = 0; i < 200; ++i) {
+            chain.Append(body.Slice(i % 10, 1));
+            expected += static_cast<char>('0' + i % 10);
+        }
+        REQUIRE(chain.FragmentCount() == 200);
+        REQUIRE(body.UseCount() == 201);
+
+        REQUIRE(WriteChain(fds[1], chain) == 200);
+        REQUIRE(chain.Empty());
+        REQUIRE(body.UseCount() == 1);
+        REQUIRE(ReadAll(fds[0], 200) == expected);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    SECTION("Fragments are held until written") {
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        REQUIRE(fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0);
+        size_t capacity = fcntl(fds[1], F_GETPIPE_SZ);
+        auto big = SharedBuffer<>::Allocate(capacity * 2, [&](std::byte* data) {
+            std::fill_n(data, capacity * 2, std::byte{'x'});
+        });
+
+        BufferChain<> chain(big);
+        size_t written = WriteChain(fds[1], chain);
+        REQUIRE(written == capacity);
+        REQUIRE(chain.Size() == capacity);
+        REQUIRE(big.UseCount() == 2);
+
+        REQUIRE(ReadAll(fds[0], written) == std::string(written, 'x'));
+        REQUIRE(WriteChain(fds[1], chain) == capacity);
+        REQUIRE(big.UseCount() == 1);
+        close(fds[0]);
+        close(fds[1]);
+    }
+
+    SECTION("Sockets") {
+        int fds[2];
+        REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        BufferChain<> chain;
+        chain.Append(Fragment("HTTP/1.1 200 OK\r\n"));
+        chain.Append(Fragment("\r\n"));
+        chain.Append(Fragment("hello"));
+        REQUIRE(SendChain(fds[0], chain) == 24);
+        REQUIRE(ReadAll(fds[1], 24) == "HTTP/1.1 200 OK\r\n\r\nhello");
+
+        close(fds[1]);
+        chain.Append(Fragment("bye"));
+        try {
+            SendChain(fds[0], chain);
+            FAIL("sendmsg to a closed peer succeeded");
+        } catch (const std::system_error& error) {
+            REQUIRE(std::string_view(error.what()).find("sendmsg") != std::string_view::npos);
+        }
+        REQUIRE(chain.Size() == 3);
+        close(fds[0]);
+    }
+
+    SECTION("A descriptor that takes nothing stops the loop") {
+        BufferChain<> chain(Fragment("stuck"));
+        int calls = 0;
+        size_t written = WriteGathered(chain, "write", [&calls](iovec*, int) {
+            ++calls;
+            return ssize_t{0};
+        });
+        REQUIRE(written == 0);
+        REQUIRE(calls == 1);
+        REQUIRE(chain.Size() == 5);
+    }
+}
@@ -0,0 +1,239 @@
+#include "shared.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include <common/my_int.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Counting policies") {
+    SECTION("Single-threaded") {
+        auto sp = MakeShared<int, SingleThreadedCounting>(42);
+        SharedPtr<int, SingleThreadedCounting> copy = sp;
+        WeakPtr<int, SingleThreadedCounting> weak = copy;
+        REQUIRE(sp.UseCount() == 2);
+        copy.Reset();
+        REQUIRE(weak.UseCount() == 1);
+        sp.Reset();
+        REQUIRE(weak.Expired());
+    }
+
+    SECTION("Atomic") {
+        SharedPtr<MyInt, AtomicCounting> sp(new MyInt(5));
+        WeakPtr<MyInt, AtomicCounting> weak(sp);
+        REQUIRE(*weak.Lock() == 5);
+        REQUIRE(MyInt::AliveCount() == 1);
+        sp.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Packed atomic counters") {
+        static_assert(sizeof(AtomicCounting) == sizeof(uint64_t));
+        static_assert(sizeof(ControlBlockForNewObject<int64_t, AtomicCounting>) ==
+                      sizeof(void*) + sizeof(uint64_t) + sizeof(int64_t));
+
+        auto sp = MakeShared<MyInt, AtomicCounting>(3);
+        WeakPtr<MyInt, AtomicCounting> weak(sp);
+        SharedPtr<MyInt, AtomicCounting> copy = sp;
+        REQUIRE(sp.UseCount() == 2);
+        sp.Reset();
+        REQUIRE(weak.UseCount() == 1);
+        copy.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(!weak.Lock());
+        REQUIRE(MyInt::AliveCount() == 0);
+
+        // The only reference of any kind takes the release path without a write to the word.
+        SharedPtr<MyInt, AtomicCounting> unique(new MyInt(4));
+        unique.Reset();
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+}
+
+struct Counted {
+    ~Counted() {
+        destroyed.fetch_add(1);
+    }
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("Atomic counting across threads") {
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 20000;
+
+    auto shared = MakeShared<Counted, AtomicCounting>();
+    WeakPtr<Counted, AtomicCounting> weak = shared;
+    std::atomic<bool> start = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            while (!start.load()) {
+            }
+            for (int j = 0; j < kIterations; ++j) {
+                SharedPtr<Counted, AtomicCounting> copy = shared;
+                WeakPtr<Counted, AtomicCounting> weak_copy = weak;
+                SharedPtr<Counted, AtomicCounting> another = copy;
+            }
+        });
+    }
+    start = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(shared.UseCount() == 1);
+    REQUIRE(Counted::destroyed.load() == 0);
+    shared.Reset();
+    REQUIRE(Counted::destroyed.load() == 1);
+    REQUIRE(weak.Expired());
+}
+
+TEST_CASE("Weak lock races with the last owner") {
+    constexpr int kRounds = 2000;
+    constexpr int kLockers = 3;
+
+    for (int round = 0; round < kRounds; ++round) {
+        auto shared = MakeShared<int, AtomicCounting>(round);
+        WeakPtr<int, AtomicCounting> weak = shared;
+        std::atomic<int> bad_locks = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kLockers; ++i) {
+            threads.emplace_back([&] {
+                for (int j = 0; j < 50; ++j) {
+                    auto locked = weak.Lock();
+                    if (locked && *locked != round) {
+                        bad_locks.fetch_add(1);
+                    }
+                }
+            });
+        }
+        shared.Reset();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(bad_locks.load() == 0);
+        REQUIRE(weak.Expired());
+    }
+}
+
+TEST_CASE("Biased counting") {
+    using Ptr = SharedPtr<Counted, BiasedCounting>;
+    Counted::destroyed = 0;
+
+    SECTION("Owner thread only") {
+        auto ptr = MakeShared<Counted, BiasedCounting>();
+        WeakPtr<Counted, BiasedCounting> weak = ptr;
+        Ptr copy = ptr;
+        REQUIRE(ptr.UseCount() == 2);
+        REQUIRE(weak.Lock());
+        ptr.Reset();
+        copy.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(Counted::destroyed.load() == 1);
+    }
+
+    SECTION("Last reference dropped by another thread") {
+        auto ptr = MakeShared<Counted, BiasedCounting>();
+        Ptr copy;
+        std::thread([&] { copy = ptr; }).join();
+        ptr.Reset();
+        REQUIRE(Counted::destroyed.load() == 0);
+        std::thread([&] { copy.Reset(); }).join();
+        REQUIRE(Counted::destroyed.load() == 1);
+    }
+
+    SECTION("Owner references dropped elsewhere are merged by the owner") {
+        auto ptr = MakeShared<Counted, BiasedCounting>();
+        Ptr copy = ptr;
+        std::thread([&] { copy.Reset(); }).join();
+        REQUIRE(ptr.UseCount() == 1);
+        ptr.Reset();
+        REQUIRE(Counted::destroyed.load() == 1);
+    }
+
+    SECTION("Weak pointers locked elsewhere before the merge") {
+        auto ptr = MakeShared<Counted, BiasedCounting>();
+        WeakPtr<Counted, BiasedCounting> weak = ptr;
+        Ptr copy = ptr;
+        // The shared counter goes negative while the owner still holds `ptr`.
+        std::thread([&] { copy.Reset(); }).join();
+        bool locked = false;
+        std::thread([&] { locked = static_cast<bool>(weak.Lock()); }).join();
+        REQUIRE(locked);
+        REQUIRE(ptr.UseCount() == 1);
+        REQUIRE(Counted::destroyed.load() == 0);
+
+        // The owner's reference moves away and is dropped: nothing is left to lock.
+        std::thread([moved = std::move(ptr)]() mutable { moved.Reset(); }).join();
+        std::thread([&] { locked = static_cast<bool>(weak.Lock()); }).join();
+        REQUIRE(!locked);
+        BiasedCounting::MergePending();
+        REQUIRE(Counted::destroyed.load() == 1);
+        REQUIRE(weak.Expired());
+    }
+
+    SECTION("Queued blocks are merged at a quiet point") {
+        auto ptr = MakeShared<Counted, BiasedCounting>();
+        std::thread([moved = std::move(ptr)]() mutable { moved.Reset(); }).join();
+        REQUIRE(Counted::destroyed.load() == 0);
+        BiasedCounting::MergePending();
+        REQUIRE(Counted::destroyed.load() == 1);
+    }
+
+    SECTION("Blocks of an exited owner") {
+        Ptr ptr;
+        Ptr copy;
+        std::thread([&] {
+            ptr = MakeShared<Counted, BiasedCounting>();
+            copy = ptr;
+        }).join();
+        ptr.Reset();
+        REQUIRE(Counted::destroyed.load() == 0);
+        copy.Reset();
+        REQUIRE(Counted::destroyed.load() == 1);
+    }
+}
+
+TEST_CASE("Biased counting across threads") {
+    constexpr int kThreads = 8;
+    constexpr int kIterations = 20000;
+    Counted::destroyed = 0;
+
+    auto shared = MakeShared<Counted, BiasedCounting>();
+    WeakPtr<Counted, BiasedCounting> weak = shared;
+    std::vector<SharedPtr<Counted, BiasedCounting>> handed_out(kThreads, shared);
+    std::atomic<bool> start = false;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&, i] {
+            while (!start.load()) {
+            }
+            for (int j = 0; j < kIterations; ++j) {
+                SharedPtr<Counted, BiasedCounting> copy = handed_out[i];
+                SharedPtr<Counted, BiasedCounting> another = copy;
+            }
+            handed_out[i].Reset();
+        });
+    }
+    start = true;
+    for (int j = 0; j < kIterations; ++j) {
+        SharedPtr<Counted, BiasedCounting> copy = shared;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(Counted::destroyed.load() == 0);
+    shared.Reset();
+    REQUIRE(Counted::destroyed.load() == 1);
+    REQUIRE(weak.Expired());
+}
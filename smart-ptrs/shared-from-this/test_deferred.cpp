@@ -0,0 +1,86 @@
+#include "deferred.h"
+#include "iterative.h"
+#include "shared.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Reclaimed {
+    ~Reclaimed() {
+        destroyed_on = std::this_thread::get_id();
+        destroyed.fetch_add(1);
+    }
+
+    static inline std::atomic<int> destroyed = 0;
+    static inline std::thread::id destroyed_on;
+};
+
+using DeferredPtr = SharedPtr<Reclaimed, DeferredDestruction<AtomicCounting>>;
+
+// Built before the reclaimer and so destroyed after it, at exit: the object dies in place.
+static DeferredPtr outlives_reclaimer(new Reclaimed);
+
+TEST_CASE("Deferred destruction") {
+    Reclaimed::destroyed = 0;
+
+    SECTION("Objects die on the reclaimer thread") {
+        auto ptr = MakeShared<Reclaimed, DeferredDestruction<AtomicCounting>>();
+        WeakPtr<Reclaimed, DeferredDestruction<AtomicCounting>> weak = ptr;
+        ptr.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(!weak.Lock());
+
+        DeferredReclaimer::Drain();
+        REQUIRE(Reclaimed::destroyed.load() == 1);
+        REQUIRE(Reclaimed::destroyed_on != std::this_thread::get_id());
+    }
+
+    SECTION("Full batches are submitted without a flush") {
+        auto before = DeferredReclaimer::GetStats();
+        for (size_t i = 0; i < DeferredReclaimer::kBatchSize; ++i) {
+            DeferredPtr ptr(new Reclaimed);
+        }
+        auto after = DeferredReclaimer::GetStats();
+        REQUIRE(after.batches == before.batches + 1);
+        REQUIRE(after.submitted == before.submitted + DeferredReclaimer::kBatchSize);
+        REQUIRE(after.max_depth >= 1);
+
+        DeferredReclaimer::Drain();
+        REQUIRE(DeferredReclaimer::GetStats().Depth() == 0);
+        REQUIRE(Reclaimed::destroyed.load() == static_cast<int>(DeferredReclaimer::kBatchSize));
+    }
+
+    SECTION("Statics may outlive the reclaimer") {
+        DeferredReclaimer::Drain();
+        REQUIRE(outlives_reclaimer.UseCount() == 1);
+    }
+}
+
+struct ChainNode {
+    using Counting = DeferredDestruction<IterativeDestruction<AtomicCounting>>;
+
+    explicit ChainNode(SharedPtr<ChainNode, Counting> next) : next(std::move(next)) {
+        alive.fetch_add(1);
+    }
+    ~ChainNode() {
+        alive.fetch_sub(1);
+    }
+
+    SharedPtr<ChainNode, Counting> next;
+    static inline std::atomic<int> alive = 0;
+};
+
+TEST_CASE("Deferred iterative destruction of a long chain") {
+    SharedPtr<ChainNode, ChainNode::Counting> head;
+    for (int i = 0; i < 500'000; ++i) {
+        head = MakeShared<ChainNode, ChainNode::Counting>(std::move(head));
+    }
+    head.Reset();
+    DeferredReclaimer::Drain();
+    REQUIRE(ChainNode::alive.load() == 0);
+}
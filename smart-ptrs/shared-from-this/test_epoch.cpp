@@ -0,0 +1,99 @@
+#include "epoch_destruction.h"
+#include "shared.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Versioned {
+    explicit Versioned(int value) : value(value) {
+    }
+    ~Versioned() {
+        value = -1;
+        destroyed.fetch_add(1);
+    }
+
+    int value;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+using EpochPtr = SharedPtr<Versioned, EpochDestruction<AtomicCounting>>;
+
+TEST_CASE("Epoch destruction") {
+    Versioned::destroyed = 0;
+
+    SECTION("Guards keep retired objects alive") {
+        auto ptr = MakeShared<Versioned, EpochDestruction<AtomicCounting>>(1);
+        WeakPtr<Versioned, EpochDestruction<AtomicCounting>> weak = ptr;
+        Versioned* raw = ptr.Get();
+        {
+            EpochGuard guard;
+            ptr.Reset();
+            REQUIRE(weak.Expired());
+            REQUIRE(!weak.Lock());
+
+            EpochDomain::Reclaim();
+            REQUIRE(Versioned::destroyed.load() == 0);
+            REQUIRE(raw->value == 1);
+        }
+        EpochDomain::Synchronize();
+        REQUIRE(Versioned::destroyed.load() == 1);
+    }
+
+    SECTION("Retired objects are freed in batches") {
+        auto before = EpochDomain::GetStats();
+        for (size_t i = 0; i < 3 * EpochDomain::kRetireBatch; ++i) {
+            EpochPtr ptr(new Versioned(static_cast<int>(i)));
+        }
+        auto after = EpochDomain::GetStats();
+        REQUIRE(after.retired == before.retired + 3 * EpochDomain::kRetireBatch);
+        REQUIRE(after.epoch > before.epoch);
+        REQUIRE(after.reclaimed > before.reclaimed);
+
+        EpochDomain::Synchronize();
+        REQUIRE(Versioned::destroyed.load() == static_cast<int>(3 * EpochDomain::kRetireBatch));
+    }
+}
+
+TEST_CASE("Epoch readers race with the writer") {
+    constexpr int kReaders = 4;
+    constexpr int kStores = 2000;
+    Versioned::destroyed = 0;
+
+    {
+        // The writer owns the current value; readers only see its raw address.
+        EpochPtr current = MakeShared<Versioned, EpochDestruction<AtomicCounting>>(0);
+        std::atomic<Versioned*> published = current.Get();
+        std::atomic<bool> done = false;
+        std::atomic<int> bad_reads = 0;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < kReaders; ++i) {
+            readers.emplace_back([&] {
+                while (!done.load()) {
+                    EpochGuard guard;
+                    if (published.load(std::memory_order_acquire)->value < 0) {
+                        bad_reads.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (int i = 1; i <= kStores; ++i) {
+            auto fresh = MakeShared<Versioned, EpochDestruction<AtomicCounting>>(i);
+            published.store(fresh.Get(), std::memory_order_release);
+            current = std::move(fresh);
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(bad_reads.load() == 0);
+    }
+
+    EpochDomain::Synchronize();
+    REQUIRE(Versioned::destroyed.load() == kStores + 1);
+}
@@ -0,0 +1,112 @@
+#include "hazard_shared.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Guarded {
+    explicit Guarded(int value) : value(value) {
+    }
+    ~Guarded() {
+        value = -1;
+        destroyed.fetch_add(1);
+    }
+
+    int value;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("HazardSharedPtr") {
+    Guarded::destroyed = 0;
+
+    SECTION("Protected objects outlive replacement") {
+        HazardSharedPtr<Guarded> cell(MakeThinShared<Guarded, AtomicCounting>(1));
+        HazardPointer hazard;
+        Guarded* first = cell.Protect(hazard);
+        REQUIRE(first->value == 1);
+
+        cell.Store(MakeThinShared<Guarded, AtomicCounting>(2));
+        HazardDomain::Reclaim();
+        REQUIRE(Guarded::destroyed.load() == 0);
+        REQUIRE(first->value == 1);
+
+        hazard.Reset();
+        HazardDomain::Reclaim();
+        REQUIRE(Guarded::destroyed.load() == 1);
+        REQUIRE(cell.Protect(hazard)->value == 2);
+    }
+
+    SECTION("Loaded pointers own the object") {
+        HazardPointer hazard;
+        SharedPtr<Guarded, AtomicCounting> loaded;
+        {
+            HazardSharedPtr<Guarded> cell(MakeThinShared<Guarded, AtomicCounting>(3));
+            loaded = cell.Load(hazard);
+            REQUIRE(loaded.UseCount() == 2);
+        }
+        HazardDomain::Reclaim();
+        REQUIRE(loaded.UseCount() == 1);
+        REQUIRE(loaded->value == 3);
+        loaded.Reset();
+        REQUIRE(Guarded::destroyed.load() == 1);
+
+        HazardSharedPtr<Guarded> empty;
+        REQUIRE(empty.Protect(hazard) == nullptr);
+        REQUIRE(!empty.Load(hazard));
+    }
+
+    SECTION("Unprotected objects are reclaimed in batches") {
+        HazardSharedPtr<Guarded> cell(MakeThinShared<Guarded, AtomicCounting>(0));
+        auto before = HazardDomain::GetStats();
+        for (size_t i = 1; i <= HazardDomain::kRetireBatch; ++i) {
+            cell.Store(MakeThinShared<Guarded, AtomicCounting>(static_cast<int>(i)));
+        }
+        auto after = HazardDomain::GetStats();
+        REQUIRE(after.retired == before.retired + HazardDomain::kRetireBatch);
+        REQUIRE(after.scans > before.scans);
+        REQUIRE(Guarded::destroyed.load() > 0);
+    }
+
+    HazardDomain::Reclaim();
+}
+
+TEST_CASE("HazardSharedPtr readers race with the writer") {
+    constexpr int kReaders = 4;
+    constexpr int kStores = 2000;
+    Guarded::destroyed = 0;
+
+    {
+        HazardSharedPtr<Guarded> cell(MakeThinShared<Guarded, AtomicCounting>(0));
+        std::atomic<bool> done = false;
+        std::atomic<int> bad_reads = 0;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < kReaders; ++i) {
+            readers.emplace_back([&] {
+                HazardPointer hazard;
+                while (!done.load()) {
+                    if (cell.Protect(hazard)->value < 0) {
+                        bad_reads.fetch_add(1);
+                    }
+                    if (cell.Load(hazard)->value < 0) {
+                        bad_reads.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (int i = 1; i <= kStores; ++i) {
+            cell.Store(MakeThinShared<Guarded, AtomicCounting>(i));
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(bad_reads.load() == 0);
+    }
+
+    HazardDomain::Reclaim();
+    REQUIRE(Guarded::destroyed.load() == kStores + 1);
+}
@@ -0,0 +1,115 @@
+#include "immortal.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ServiceConfig {
+    constexpr ServiceConfig(int threads, const char* name) : threads(threads), name(name) {
+    }
+
+    int threads;
+    const char* name;
+};
+
+// Built at compile time: no allocation and no constructor runs at startup.
+static constinit ImmortalShared<const ServiceConfig> kDefaults(8, "default");
+static constinit SharedPtr<const ServiceConfig, ImmortalAtomicCounting> kDefaultConfig(kDefaults);
+
+// Immortality is opt-in: the plain policies keep a single read-modify-write per update.
+static_assert(!std::is_constructible_v<AtomicCounting, ImmortalTag>);
+static_assert(!std::is_constructible_v<SingleThreadedCounting, ImmortalTag>);
+
+struct NeverDestroyed {
+    ~NeverDestroyed() {
+        destroyed.fetch_add(1);
+    }
+
+    int value = 7;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("Immortal SharedPtr") {
+    SECTION("Constant-initialized") {
+        REQUIRE(kDefaultConfig->threads == 8);
+        REQUIRE(kDefaultConfig.Get() == kDefaults.Get());
+    }
+
+    SECTION("Copies do not count") {
+        size_t count = kDefaultConfig.UseCount();
+        REQUIRE(count > 1000);
+        EXPECT_ZERO_ALLOCATIONS(auto copy = kDefaultConfig; auto moved = std::move(copy);
+                                auto again = moved; REQUIRE(again.UseCount() == count););
+        REQUIRE(kDefaultConfig.UseCount() == count);
+
+        {
+            SharedPtr<const ServiceConfig, ImmortalAtomicCounting> other;
+            other = kDefaultConfig;
+            other = SharedPtr<const ServiceConfig, ImmortalAtomicCounting>(kDefaults);
+            REQUIRE(kDefaultConfig.UseCount() == count);
+        }
+        REQUIRE(kDefaultConfig.UseCount() == count);
+    }
+
+    SECTION("Weak pointers") {
+        WeakPtr<const ServiceConfig, ImmortalAtomicCounting> weak(kDefaultConfig);
+        REQUIRE(!weak.Expired());
+        auto locked = weak.Lock();
+        REQUIRE(locked.Get() == kDefaults.Get());
+        weak.Reset();
+    }
+
+    SECTION("Never destroyed") {
+        static ImmortalShared<NeverDestroyed> object;
+        {
+            auto first = object.Share();
+            auto second = first;
+            first.Reset();
+            REQUIRE(second->value == 7);
+        }
+        REQUIRE(NeverDestroyed::destroyed.load() == 0);
+        REQUIRE(object.Share()->value == 7);
+    }
+
+    SECTION("Mortal blocks of the same policy") {
+        auto mortal = MakeShared<int, ImmortalAtomicCounting>(5);
+        WeakPtr<int, ImmortalAtomicCounting> weak(mortal);
+        auto copy = mortal;
+        REQUIRE(mortal.UseCount() == 2);
+        mortal.Reset();
+        REQUIRE(*weak.Lock() == 5);
+        copy.Reset();
+        REQUIRE(weak.Expired());
+    }
+
+    SECTION("Many threads") {
+        constexpr int kThreads = 8;
+        constexpr int kCopies = 10000;
+        size_t count = kDefaultConfig.UseCount();
+        std::atomic<int> sum = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.emplace_back([&] {
+                int local = 0;
+                for (int j = 0; j < kCopies; ++j) {
+                    auto copy = kDefaultConfig;
+                    local += copy->threads;
+                }
+                sum.fetch_add(local);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(sum.load() == kThreads * kCopies * 8);
+        REQUIRE(kDefaultConfig.UseCount() == count);
+    }
+}
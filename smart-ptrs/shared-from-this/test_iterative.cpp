@@ -0,0 +1,86 @@
+#include "iterative.h"
+#include "shared.h"
+#include "slab.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Counting>
+struct ListNode {
+    explicit ListNode(SharedPtr<ListNode, Counting> next) : next(std::move(next)) {
+        ++alive;
+    }
+    ~ListNode() {
+        --alive;
+    }
+
+    SharedPtr<ListNode, Counting> next;
+    static inline int alive = 0;
+};
+
+template <typename Counting>
+SharedPtr<ListNode<Counting>, Counting> MakeList(int length) {
+    SharedPtr<ListNode<Counting>, Counting> head;
+    for (int i = 0; i < length; ++i) {
+        head = MakeShared<ListNode<Counting>, Counting>(std::move(head));
+    }
+    return head;
+}
+
+TEST_CASE("Iterative destruction") {
+    SECTION("Long list does not overflow the stack") {
+        using Counting = IterativeDestruction<SingleThreadedCounting>;
+        auto head = MakeList<Counting>(1'000'000);
+        REQUIRE(ListNode<Counting>::alive == 1'000'000);
+        head.Reset();
+        REQUIRE(ListNode<Counting>::alive == 0);
+    }
+
+    SECTION("Shared tails survive") {
+        using Counting = IterativeDestruction<AtomicCounting>;
+        auto head = MakeList<Counting>(1000);
+        auto tail = head->next->next;
+        WeakPtr<ListNode<Counting>, Counting> weak_head = head;
+        head.Reset();
+        REQUIRE(weak_head.Expired());
+        REQUIRE(ListNode<Counting>::alive == 998);
+        tail.Reset();
+        REQUIRE(ListNode<Counting>::alive == 0);
+    }
+
+    SECTION("Composes with slab blocks") {
+        using Counting = SlabAllocated<IterativeDestruction<SingleThreadedCounting>>;
+        auto head = MakeList<Counting>(100'000);
+        head.Reset();
+        REQUIRE(ListNode<Counting>::alive == 0);
+    }
+}
+
+struct TreeNode {
+    using Ptr = SharedPtr<TreeNode, IterativeDestruction<SingleThreadedCounting>>;
+
+    TreeNode() {
+        ++alive;
+    }
+    ~TreeNode() {
+        --alive;
+    }
+
+    Ptr left;
+    Ptr right;
+    static inline int alive = 0;
+};
+
+TEST_CASE("Iterative destruction of a degenerate tree") {
+    auto root = MakeShared<TreeNode, IterativeDestruction<SingleThreadedCounting>>();
+    TreeNode* last = root.Get();
+    for (int i = 0; i < 300'000; ++i) {
+        last->left = MakeShared<TreeNode, IterativeDestruction<SingleThreadedCounting>>();
+        last->right = MakeShared<TreeNode, IterativeDestruction<SingleThreadedCounting>>();
+        last = (i % 2 == 0 ? last->left : last->right).Get();
+    }
+    root.Reset();
+    REQUIRE(TreeNode::alive == 0);
+}
@@ -0,0 +1,75 @@
+#include "mapped_file.h"
+
+#include <catch.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// A file in the temporary directory, removed at the end of the test.
+class TempFile {
+public:
+    explicit TempFile(const std::vector<uint32_t>& words) {
+        int fd = mkstemp(path_);
+        REQUIRE(fd != -1);
+        size_t size = words.size() * sizeof(uint32_t);
+        REQUIRE(write(fd, words.data(), size) == static_cast<ssize_t>(size));
+        close(fd);
+    }
+    ~TempFile() {
+        unlink(path_);
+    }
+
+    const char* Path() const {
+        return path_;
+    }
+
+private:
+    char path_[32] = "/tmp/smart-ptrs-XXXXXX";
+};
+
+static bool IsMapped(const void* address) {
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    void* start = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) / page * page);
+    return msync(start, page, MS_ASYNC) == 0;
+}
+
+TEST_CASE("MapFile") {
+    std::vector<uint32_t> words(4096);
+    for (size_t i = 0; i < words.size(); ++i) {
+        words[i] = static_cast<uint32_t>(i * 3);
+    }
+    TempFile file(words);
+
+    SECTION("Views keep the mapping") {
+        auto mapped = MapFile(file.Path(), MapAdvice::kSequential);
+        REQUIRE(mapped.Size() == words.size() * sizeof(uint32_t));
+        const std::byte* base = mapped.Data();
+
+        auto tail = mapped.Slice(sizeof(uint32_t) * 4000, sizeof(uint32_t) * 96);
+        auto typed = tail.ViewAs<uint32_t>();
+        mapped.Reset();
+        REQUIRE(IsMapped(base));
+        REQUIRE(typed[0] == 12000);
+        REQUIRE(typed[95] == 4095 * 3);
+
+        Advise(tail, MapAdvice::kWillNeed);
+        Advise(tail, MapAdvice::kHugePage);
+        tail.Reset();
+        REQUIRE(IsMapped(base));
+        typed.Reset();
+        REQUIRE(!IsMapped(base));
+    }
+
+    SECTION("Empty and missing files") {
+        TempFile empty({});
+        REQUIRE(MapFile(empty.Path()).Empty());
+        REQUIRE_THROWS_AS(MapFile("/nonexistent/smart-ptrs"), std::system_error);
+    }
+}
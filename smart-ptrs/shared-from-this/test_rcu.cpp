@@ -0,0 +1,164 @@
+#include "rcu_cell.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Config {
+    Config(int version, std::string name) : version(version), name(std::move(name)) {
+        alive.fetch_add(1);
+    }
+    Config(const Config& other) : version(other.version), name(other.name) {
+        alive.fetch_add(1);
+    }
+    ~Config() {
+        version = -1;
+        alive.fetch_sub(1);
+    }
+
+    int version;
+    std::string name;
+    static inline std::atomic<int> alive = 0;
+};
+
+// A replaced version is released by its cell after one grace period and destroyed after
+// the next.
+static void ReclaimReplaced() {
+    EpochDomain::Synchronize();
+    EpochDomain::Synchronize();
+}
+
+TEST_CASE("RcuCell") {
+    SECTION("Snapshots keep their version") {
+        {
+            RcuCell<Config> cell(1, "first");
+            auto before = cell.Read();
+            REQUIRE(before->version == 1);
+
+            cell.Update([](Config& config) {
+                ++config.version;
+                config.name = "second";
+            });
+            auto after = cell.Read();
+            REQUIRE(after->version == 2);
+            REQUIRE(after->name == "second");
+            REQUIRE(before->version == 1);
+            REQUIRE(before->name == "first");
+
+            cell.Store(Config(3, "third"));
+            REQUIRE(cell.Read()->name == "third");
+            REQUIRE(before->name == "first");
+        }
+        ReclaimReplaced();
+        REQUIRE(Config::alive.load() == 0);
+    }
+
+    SECTION("Loaded versions are owned") {
+        RcuCell<Config>::Pointer kept;
+        {
+            RcuCell<Config> cell(7, "kept");
+            kept = cell.Load();
+            REQUIRE(kept.UseCount() == 2);
+            cell.Store(Config(8, "next"));
+            // The cell lets go of the old version after a grace period.
+            REQUIRE(kept.UseCount() == 2);
+            EpochDomain::Synchronize();
+            REQUIRE(kept.UseCount() == 1);
+        }
+        EpochDomain::Synchronize();
+        REQUIRE(kept->version == 7);
+        REQUIRE(Config::alive.load() == 1);
+        kept.Reset();
+        EpochDomain::Synchronize();
+        REQUIRE(Config::alive.load() == 0);
+    }
+}
+
+TEST_CASE("RcuCell readers race with updates") {
+    constexpr int kReaders = 4;
+    constexpr int kUpdates = 1000;
+
+    {
+        RcuCell<Config> cell(0, "config");
+        std::atomic<bool> done = false;
+        std::atomic<int> bad_reads = 0;
+        std::vector<std::thread> readers;
+        for (int i = 0; i < kReaders; ++i) {
+            readers.emplace_back([&] {
+                int last = 0;
+                while (!done.load()) {
+                    int version = cell.Read()->version;
+                    auto owned = cell.Load();
+                    if (version < last || owned->version < version) {
+                        bad_reads.fetch_add(1);
+                    }
+                    last = version;
+                }
+            });
+        }
+        for (int i = 0; i < kUpdates; ++i) {
+            cell.Update([](Config& config) { ++config.version; });
+        }
+        done = true;
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(bad_reads.load() == 0);
+        REQUIRE(cell.Read()->version == kUpdates);
+    }
+
+    ReclaimReplaced();
+    REQUIRE(Config::alive.load() == 0);
+}
+
+// Every loaded pointer is the only other owner for a moment: its drop and the cell's release
+// race with the loads of the other threads.
+TEST_CASE("RcuCell loads race with the release of replaced versions") {
+    constexpr int kReaders = 4;
+    constexpr int kWriters = 2;
+    constexpr int kUpdates = 2000;
+
+    {
+        RcuCell<Config> cell(0, "config");
+        std::atomic<int> writers_left = kWriters;
+        std::atomic<int> bad_reads = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kReaders; ++i) {
+            threads.emplace_back([&] {
+                while (writers_left.load() != 0) {
+                    auto owned = cell.Load();
+                    if (owned->version < 0 || owned.UseCount() == 0) {
+                        bad_reads.fetch_add(1);
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < kWriters; ++i) {
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < kUpdates; ++j) {
+                    if (j % 2 == 0) {
+                        cell.Store(Config(j, "stored"));
+                    } else {
+                        cell.Update([](Config& config) { config.name = "updated"; });
+                    }
+                    if (j % 256 == i) {
+                        EpochDomain::Reclaim();
+                    }
+                }
+                writers_left.fetch_sub(1);
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(bad_reads.load() == 0);
+    }
+
+    ReclaimReplaced();
+    REQUIRE(Config::alive.load() == 0);
+}
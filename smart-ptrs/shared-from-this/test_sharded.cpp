@@ -0,0 +1,86 @@
+#include "sharded.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct Schema {
+    explicit Schema(int version) : version(version) {
+    }
+    ~Schema() {
+        destroyed.fetch_add(1);
+    }
+
+    int version;
+    static inline std::atomic<int> destroyed = 0;
+};
+
+TEST_CASE("ShardedSharedPtr") {
+    Schema::destroyed = 0;
+
+    SECTION("Owner alone") {
+        auto schema = MakeShardedShared<Schema>(1);
+        REQUIRE(schema->version == 1);
+        REQUIRE(schema.Share().UseCount() == 2);
+        schema.Reset();
+        REQUIRE(!schema);
+        REQUIRE(Schema::destroyed.load() == 1);
+    }
+
+    SECTION("Copies outlive the owner") {
+        auto schema = MakeShardedShared<Schema>(2);
+        auto copy = schema.Share();
+        WeakPtr<Schema, ShardedCounting> weak = copy;
+        std::vector<SharedPtr<Schema, ShardedCounting>> copies;
+        std::thread([&] {
+            for (int i = 0; i < 10; ++i) {
+                copies.push_back(schema.Share());
+            }
+        }).join();
+
+        schema.Reset();
+        REQUIRE(Schema::destroyed.load() == 0);
+        REQUIRE(copy.UseCount() == 11);
+        REQUIRE(weak.Lock()->version == 2);
+        copies.clear();
+        copy.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(Schema::destroyed.load() == 1);
+    }
+}
+
+TEST_CASE("ShardedSharedPtr teardown races with copies") {
+    constexpr int kThreads = 6;
+    constexpr int kRounds = 200;
+    Schema::destroyed = 0;
+
+    for (int round = 0; round < kRounds; ++round) {
+        auto schema = MakeShardedShared<Schema>(round);
+        std::vector<SharedPtr<Schema, ShardedCounting>> seeds(kThreads, schema.Share());
+        std::atomic<int> bad_reads = 0;
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.emplace_back([&, i] {
+                for (int j = 0; j < 100; ++j) {
+                    auto copy = seeds[i];
+                    if (copy->version != round) {
+                        bad_reads.fetch_add(1);
+                    }
+                }
+                seeds[i].Reset();
+            });
+        }
+        schema.Reset();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        REQUIRE(bad_reads.load() == 0);
+        REQUIRE(Schema::destroyed.load() == round + 1);
+    }
+}
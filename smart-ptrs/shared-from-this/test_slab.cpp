@@ -0,0 +1,89 @@
+#include "shared.h"
+#include "slab.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <common/my_int.h>
+
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using SlabPtr = SharedPtr<MyInt, SlabAllocated<SingleThreadedCounting>>;
+using AtomicSlabPtr = SharedPtr<int, SlabAllocated<AtomicCounting>>;
+
+TEST_CASE("Slab control blocks") {
+    SECTION("Adoption makes no global allocations in steady state") {
+        { SlabPtr warm_up(new MyInt(0)); }
+        MyInt* first = new MyInt(1);
+        MyInt* second = new MyInt(2);
+        EXPECT_ZERO_ALLOCATIONS(SlabPtr p(first); SlabPtr copy = p; p.Reset(second););
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("MakeShared makes no global allocations in steady state") {
+        { auto warm_up = MakeShared<MyInt, SlabAllocated<SingleThreadedCounting>>(0); }
+        EXPECT_ZERO_ALLOCATIONS(auto p = MakeShared<MyInt, SlabAllocated<SingleThreadedCounting>>(1);
+                                WeakPtr<MyInt, SlabAllocated<SingleThreadedCounting>> weak = p;
+                                REQUIRE(*weak.Lock() == 1););
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Blocks are reused") {
+        std::vector<SlabPtr> ptrs;
+        for (int i = 0; i < 100; ++i) {
+            ptrs.emplace_back(new MyInt(i));
+        }
+        SlabStats before = ControlBlockSlab::GetStats();
+        ptrs.clear();
+        SlabStats freed = ControlBlockSlab::GetStats();
+        REQUIRE(freed.in_use + 100 == before.in_use);
+        for (int i = 0; i < 100; ++i) {
+            ptrs.emplace_back(new MyInt(i));
+        }
+        SlabStats after = ControlBlockSlab::GetStats();
+        REQUIRE(after.in_use == before.in_use);
+        REQUIRE(after.chunks == before.chunks);
+        REQUIRE(after.Occupancy() > 0);
+        REQUIRE(after.in_use <= after.capacity);
+    }
+}
+
+TEST_CASE("Slab remote frees") {
+    constexpr int kThreads = 4;
+    constexpr int kBlocks = 10000;
+
+    // Threads allocate, the main thread frees: the blocks travel back through remote lists.
+    for (int round = 0; round < 3; ++round) {
+        std::vector<std::vector<AtomicSlabPtr>> results(kThreads);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < kThreads; ++i) {
+            threads.emplace_back([&results, i] {
+                for (int j = 0; j < kBlocks; ++j) {
+                    results[i].push_back(MakeShared<int, SlabAllocated<AtomicCounting>>(j));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        size_t in_use = ControlBlockSlab::GetStats().in_use;
+        results.clear();
+        REQUIRE(ControlBlockSlab::GetStats().in_use + kThreads * kBlocks == in_use);
+    }
+
+    // Heaps of exited threads are reused, so repeated rounds do not grow the slab.
+    size_t chunks = ControlBlockSlab::GetStats().chunks;
+    std::vector<AtomicSlabPtr> shared;
+    std::thread([&shared] {
+        for (int j = 0; j < kBlocks; ++j) {
+            shared.push_back(MakeShared<int, SlabAllocated<AtomicCounting>>(j));
+        }
+    }).join();
+    shared.clear();
+    REQUIRE(ControlBlockSlab::GetStats().chunks == chunks);
+}
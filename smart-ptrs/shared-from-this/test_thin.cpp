@@ -0,0 +1,86 @@
+#include "thin.h"
+#include "weak.h"
+
+#include <catch.hpp>
+
+#include "allocations_checker.h"
+
+#include <common/my_int.h>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct ThinBase {
+    virtual ~ThinBase() = default;
+};
+
+struct ThinDerived : ThinBase {};
+
+TEST_CASE("ThinSharedPtr") {
+    SECTION("Sizeof") {
+        REQUIRE(sizeof(ThinSharedPtr<MyInt>) == sizeof(void*));
+        REQUIRE(sizeof(ThinWeakPtr<MyInt>) == sizeof(void*));
+    }
+
+    SECTION("Ownership") {
+        ThinSharedPtr<MyInt> ptr;
+        EXPECT_ONE_ALLOCATION(ptr = MakeThinShared<MyInt>(4););
+        REQUIRE(*ptr == 4);
+        auto copy = ptr;
+        REQUIRE(ptr.UseCount() == 2);
+        REQUIRE(copy == ptr);
+        ptr.Reset();
+        REQUIRE(!ptr);
+        REQUIRE(MyInt::AliveCount() == 1);
+        copy = std::move(ptr);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+
+    SECTION("Weak") {
+        auto ptr = MakeThinShared<MyInt, AtomicCounting>(1);
+        ThinWeakPtr<MyInt, AtomicCounting> weak = ptr;
+        REQUIRE(weak.Lock().Get() == ptr.Get());
+        REQUIRE(weak.UseCount() == 1);
+        ptr.Reset();
+        REQUIRE(weak.Expired());
+        REQUIRE(!weak.Lock());
+    }
+
+    SECTION("To SharedPtr") {
+        auto thin = MakeThinShared<MyInt>(2);
+        SharedPtr<MyInt> shared;
+        EXPECT_ZERO_ALLOCATIONS(shared = thin.ToShared(););
+        REQUIRE(shared.Get() == thin.Get());
+        REQUIRE(shared.UseCount() == 2);
+
+        WeakPtr<MyInt> weak = shared;
+        shared = std::move(thin).ToShared();
+        REQUIRE(!thin);
+        REQUIRE(shared.UseCount() == 1);
+        shared.Reset();
+        REQUIRE(weak.Expired());
+    }
+
+    SECTION("From SharedPtr") {
+        auto shared = MakeShared<MyInt>(3);
+        auto thin = ThinSharedPtr<MyInt>::FromShared(shared);
+        REQUIRE(thin.Get() == shared.Get());
+        REQUIRE(shared.UseCount() == 2);
+
+        thin = ThinSharedPtr<MyInt>::FromShared(std::move(shared));
+        REQUIRE(!shared);
+        REQUIRE(thin.UseCount() == 1);
+    }
+
+    SECTION("Only MakeShared objects of the exact type") {
+        SharedPtr<MyInt> adopted(new MyInt(1));
+        REQUIRE(!ThinSharedPtr<MyInt>::FromShared(adopted));
+
+        SharedPtr<ThinBase> base = MakeShared<ThinDerived>();
+        REQUIRE(!ThinSharedPtr<ThinBase>::FromShared(std::move(base)));
+        REQUIRE(base);
+
+        auto pair = MakeShared<std::pair<MyInt, MyInt>>(1, 2);
+        SharedPtr<MyInt> alias(pair, &pair->second);
+        REQUIRE(!ThinSharedPtr<MyInt>::FromShared(alias));
+    }
+}
@@ -175,3 +175,22 @@ TEST_CASE("Lifetimes") {
         delete wp;
     }
 }
+
+TEST_CASE("TryLock") {
+    SharedPtr<MyInt> sp = MakeShared<MyInt>(3);
+    WeakPtr<MyInt> weak(sp);
+    SharedPtr<MyInt> locked;
+    REQUIRE(weak.TryLock(locked));
+    REQUIRE(*locked == 3);
+    REQUIRE(sp.UseCount() == 2);
+
+    locked.Reset();
+    sp.Reset();
+    REQUIRE(!weak.TryLock(locked));
+    REQUIRE(!locked);
+    REQUIRE(!weak.Lock());
+    REQUIRE_THROWS_AS(SharedPtr<MyInt>(weak), BadWeakPtr);
+
+    WeakPtr<MyInt> empty;
+    REQUIRE(!empty.TryLock(locked));
+}
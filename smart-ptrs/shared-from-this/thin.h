@@ -0,0 +1,245 @@
+#pragma once
+
+#include "shared.h"
+
+#include <cstddef>  // std::nullptr_t
+#include <type_traits>
+#include <utility>
+
+template <typename T, typename Counting = SingleThreadedCounting>
+class ThinWeakPtr;
+
+// One-pointer `SharedPtr` for objects created by `MakeShared` (see `MakeThinShared`).
+// Only the block is stored: the object lives at a fixed offset inside it.
+// Aliasing and adopting raw pointers are not supported.
+template <typename T, typename Counting = SingleThreadedCounting>
+class ThinSharedPtr {
+public:
+    using Block = ControlBlockForNewObject<T, Counting, DefaultBlockAllocator<Counting, T>>;
+
+    template <typename P, typename C>
+    friend class ThinWeakPtr;
+
+    template <typename P>
+    friend class HazardSharedPtr;
+
+    template <typename P>
+    friend class RcuCell;
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Constructors
+
+    ThinSharedPtr() = default;
+
+    ThinSharedPtr(std::nullptr_t) {
+    }
+
+    ThinSharedPtr(const ThinSharedPtr& other) : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->GetCounting().IncStrong();
+        }
+    }
+
+    ThinSharedPtr(ThinSharedPtr&& other) : block_(std::exchange(other.block_, nullptr)) {
+    }
+
+    // Takes over `shared` if it owns a `MakeShared` object of exactly `T`;
+    // otherwise returns an empty pointer and leaves `shared` alone.
+    static ThinSharedPtr FromShared(SharedPtr<T, Counting>&& shared) {
+        ThinSharedPtr result;
+        if (shared.block_ != nullptr && Block::IsInstance(shared.block_) &&
+            static_cast<Block*>(shared.block_)->GetObject() == shared.pointer_) {
+            result.block_ = static_cast<Block*>(std::exchange(shared.block_, nullptr));
+            shared.pointer_ = nullptr;
+        }
+        return result;
+    }
+
+    static ThinSharedPtr FromShared(const SharedPtr<T, Counting>& shared) {
+        return FromShared(SharedPtr<T, Counting>(shared));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // `operator=`-s
+
+    ThinSharedPtr& operator=(const ThinSharedPtr& other) {
+        if (other.block_ != nullptr) {
+            other.block_->GetCounting().IncStrong();
+        }
+        ReleaseBlock();
+        block_ = other.block_;
+        return *this;
+    }
+
+    ThinSharedPtr& operator=(ThinSharedPtr&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        ReleaseBlock();
+        block_ = std::exchange(other.block_, nullptr);
+        return *this;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Destructor
+
+    ~ThinSharedPtr() {
+        ReleaseBlock();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Modifiers
+
+    void Reset() {
+        ReleaseBlock();
+        block_ = nullptr;
+    }
+    void Swap(ThinSharedPtr& other) {
+        std::swap(block_, other.block_);
+    }
+
+    // Shares ownership with a regular pointer.
+    SharedPtr<T, Counting> ToShared() const& {
+        if (block_ == nullptr) {
+            return SharedPtr<T, Counting>();
+        }
+        block_->GetCounting().IncStrong();
+        return SharedPtr<T, Counting>(block_, block_->GetObject());
+    }
+    // Hands the reference over without touching the counter.
+    SharedPtr<T, Counting> ToShared() && {
+        if (block_ == nullptr) {
+            return SharedPtr<T, Counting>();
+        }
+        Block* block = std::exchange(block_, nullptr);
+        return SharedPtr<T, Counting>(block, block->GetObject());
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // Observers
+
+    T* Get() const {
+        return block_ == nullptr ? nullptr : block_->GetObject();
+    }
+    T& operator*() const {
+        return *block_->GetObject();
+    }
+    T* operator->() const {
+        return block_->GetObject();
+    }
+    size_t UseCount() const {
+        if (!block_) {
+            return 0;
+        }
+        return block_->GetCounting().StrongCount();
+    }
+    explicit operator bool() const {
+        return block_ != nullptr;
+    }
+
+private:
+    explicit ThinSharedPtr(Block* block) : block_(block) {
+    }
+
+    void ReleaseBlock() {
+        if (block_) {
+            block_->ReleaseStrong();
+        }
+    }
+
+    Block* block_ = nullptr;
+};
+
+template <typename T, typename U, typename Counting>
+inline bool operator==(const ThinSharedPtr<T, Counting>& left,
+                       const ThinSharedPtr<U, Counting>& right) {
+    return left.Get() == right.Get();
+}
+
+// Weak counterpart of `ThinSharedPtr`, also one pointer.
+template <typename T, typename Counting>
+class ThinWeakPtr {
+    using Block = typename ThinSharedPtr<T, Counting>::Block;
+
+public:
+    ThinWeakPtr() = default;
+
+    ThinWeakPtr(const ThinWeakPtr& other) : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->GetCounting().IncWeak();
+        }
+    }
+
+    ThinWeakPtr(ThinWeakPtr&& other) : block_(std::exchange(other.block_, nullptr)) {
+    }
+
+    ThinWeakPtr(const ThinSharedPtr<T, Counting>& other) : block_(other.block_) {
+        if (block_ != nullptr) {
+            block_->GetCounting().IncWeak();
+        }
+    }
+
+    ThinWeakPtr& operator=(const ThinWeakPtr& other) {
+        if (other.block_ != nullptr) {
+            other.block_->GetCounting().IncWeak();
+        }
+        ReleaseBlock();
+        block_ = other.block_;
+        return *this;
+    }
+
+    ThinWeakPtr& operator=(ThinWeakPtr&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        ReleaseBlock();
+        block_ = std::exchange(other.block_, nullptr);
+        return *this;
+    }
+
+    ~ThinWeakPtr() {
+        ReleaseBlock();
+    }
+
+    void Reset() {
+        ReleaseBlock();
+        block_ = nullptr;
+    }
+    void Swap(ThinWeakPtr& other) {
+        std::swap(block_, other.block_);
+    }
+
+    size_t UseCount() const {
+        if (!block_) {
+            return 0;
+        }
+        return block_->GetCounting().StrongCount();
+    }
+    bool Expired() const {
+        return UseCount() == 0;
+    }
+
+    // Never throws: returns an empty pointer if the object is gone.
+    ThinSharedPtr<T, Counting> Lock() const {
+        if (block_ == nullptr || !block_->GetCounting().TryIncStrong()) {
+            return ThinSharedPtr<T, Counting>();
+        }
+        return ThinSharedPtr<T, Counting>(block_);
+    }
+
+private:
+    void ReleaseBlock() {
+        if (block_) {
+            block_->ReleaseWeak();
+        }
+    }
+
+    Block* block_ = nullptr;
+};
+
+// Allocate memory only once
+template <typename T, typename Counting = SingleThreadedCounting, typename... Args>
+ThinSharedPtr<T, Counting> MakeThinShared(Args&&... args) {
+    return ThinSharedPtr<T, Counting>::FromShared(
+        MakeShared<T, Counting>(std::forward<Args>(args)...));
+}
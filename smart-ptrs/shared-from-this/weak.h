@@ -2,41 +2,45 @@
 
 #include "sw_fwd.h"  // Forward declaration
 
+#include <type_traits>
+
 // https://en.cppreference.com/w/cpp/memory/weak_ptr
-template <typename T>
+template <typename T, typename Counting>
 class WeakPtr {
 public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
-    template <class Pointer>
+    template <class Pointer, typename C>
     friend class SharedPtr;
 
-    template <class Pointer>
+    template <class Pointer, typename C>
     friend class WeakPtr;
 
+    using ElementType = std::remove_extent_t<T>;
+
     WeakPtr() {
         object_ = nullptr;
         block_weak_ = nullptr;
     }
 
-    WeakPtr(const WeakPtr<T>& other) {
+    WeakPtr(const WeakPtr& other) {
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
         if (block_weak_ != nullptr) {
-            ++block_weak_->GetWeakCounter();
+            block_weak_->GetCounting().IncWeak();
         }
     }
 
     template <class Pointer>
-    WeakPtr(const WeakPtr<Pointer>& other) {
+    WeakPtr(const WeakPtr<Pointer, Counting>& other) {
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
         if (block_weak_ != nullptr) {
-            ++block_weak_->GetWeakCounter();
+            block_weak_->GetCounting().IncWeak();
         }
     }
 
-    WeakPtr(WeakPtr<T>&& other) {
+    WeakPtr(WeakPtr&& other) {
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
         other.block_weak_ = nullptr;
@@ -44,7 +48,7 @@ public:
     }
 
     template <class Pointer>
-    WeakPtr(WeakPtr<Pointer>&& other) {
+    WeakPtr(WeakPtr<Pointer, Counting>&& other) {
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
         other.block_weak_ = nullptr;
@@ -53,33 +57,40 @@ public:
 
     // Demote `SharedPtr`
     // #2 from https://en.cppreference.com/w/cpp/memory/weak_ptr/weak_ptr
-    WeakPtr(const SharedPtr<T>& other) {
+    WeakPtr(const SharedPtr<T, Counting>& other) {
         this->block_weak_ = other.block_;
         this->object_ = other.pointer_;
-        ++block_weak_->GetWeakCounter();
+        if (block_weak_ != nullptr) {
+            block_weak_->GetCounting().IncWeak();
+        }
     }
 
     template <class Pointer>
-    WeakPtr(const SharedPtr<Pointer>& other) {
+    WeakPtr(const SharedPtr<Pointer, Counting>& other) {
         this->block_weak_ = other.block_;
         this->object_ = other.pointer_;
-        ++block_weak_->GetWeakCounter();
+        if (block_weak_ != nullptr) {
+            block_weak_->GetCounting().IncWeak();
+        }
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // `operator=`-s
 
     WeakPtr& operator=(const WeakPtr& other) {
-        Deleter();
         if (other.block_weak_ != nullptr) {
-            ++other.block_weak_->GetWeakCounter();
+            other.block_weak_->GetCounting().IncWeak();
         }
+        Deleter();
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
         return *this;
     }
 
     WeakPtr& operator=(WeakPtr&& other) {
+        if (this == &other) {
+            return *this;
+        }
         Deleter();
         this->block_weak_ = other.block_weak_;
         this->object_ = other.object_;
@@ -116,44 +127,36 @@ public:
         if (!block_weak_) {
             return 0;
         }
-        return block_weak_->GetStrongCounter();
+        return block_weak_->GetCounting().StrongCount();
     }
 
     bool Expired() const {
-        if (!UseCount()) {
-            return true;
-        }
-        if (block_weak_->GetStrongCounter() == 0) {
-            return true;
-        }
-        return false;
+        return UseCount() == 0;
+    }
+
+    // Never throws: returns an empty pointer if the object is gone.
+    SharedPtr<T, Counting> Lock() const {
+        SharedPtr<T, Counting> result;
+        TryLock(result);
+        return result;
     }
 
-    SharedPtr<T> Lock() const {
-        if (Expired()) {
-            return SharedPtr<T>();
-        } else {
-            return SharedPtr<T>(*this);
+    // Takes a strong reference only if the object is still alive, so it cannot
+    // race with the last owner. On success stores it in `out` and returns true.
+    bool TryLock(SharedPtr<T, Counting>& out) const {
+        if (block_weak_ == nullptr || !block_weak_->GetCounting().TryIncStrong()) {
+            return false;
         }
+        out = SharedPtr<T, Counting>(block_weak_, object_);
+        return true;
     }
 
 private:
-    ControlBlock* block_weak_;
-    T* object_;
+    ControlBlock<Counting>* block_weak_;
+    ElementType* object_;
     void Deleter() {
         if (block_weak_) {
-            --this->block_weak_->GetWeakCounter();
-            if (block_weak_->GetWeakCounter() == 0 && block_weak_->GetStrongCounter() == 0) {
-                delete block_weak_;
-            }
-            //            else if (block_weak_->GetWeakCounter() == 0 &&
-            //            block_weak_->GetStrongCounter() > 0) {
-            //                // like a shared_ptr, don't delete while strong = 0;
-            //            }
-            //            else if (block_weak_->GetWeakCounter() > 0 &&
-            //            block_weak_->GetStrongCounter() == 0) {
-            //                delete object_;
-            //            }
+            block_weak_->ReleaseWeak();
         }
     }
 };
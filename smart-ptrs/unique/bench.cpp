@@ -0,0 +1,39 @@
+#include "unique.h"
+
+#include <benchmark/benchmark.h>
+
+static void BM_RawNewDelete(benchmark::State& state) {
+    for (auto _ : state) {
+        int* ptr = new int(42);
+        benchmark::DoNotOptimize(ptr);
+        delete ptr;
+    }
+}
+BENCHMARK(BM_RawNewDelete);
+
+static void BM_UniquePtr(benchmark::State& state) {
+    for (auto _ : state) {
+        UniquePtr<int> ptr(new int(42));
+        benchmark::DoNotOptimize(ptr.Get());
+    }
+}
+BENCHMARK(BM_UniquePtr);
+
+static void BM_UniquePtrMove(benchmark::State& state) {
+    for (auto _ : state) {
+        UniquePtr<int> ptr(new int(42));
+        UniquePtr<int> other(std::move(ptr));
+        benchmark::DoNotOptimize(other.Get());
+    }
+}
+BENCHMARK(BM_UniquePtrMove);
+
+static void BM_UniquePtrRingBufferTrace(benchmark::State& state) {
+    for (auto _ : state) {
+        UniquePtr<int, DefaultDeleter<int>, RingBufferTrace<>> ptr(new int(42));
+        benchmark::DoNotOptimize(ptr.Get());
+    }
+}
+BENCHMARK(BM_UniquePtrRingBufferTrace);
+
+BENCHMARK_MAIN();
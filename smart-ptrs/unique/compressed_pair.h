@@ -98,6 +98,13 @@ public:
     CompressedPair() : FirstElement<F>(), SecondElement<S>() {
     }
 
+    // Leaves the second element default-initialized.
+    explicit CompressedPair(F&& first) : FirstElement<F>(std::move(first)) {
+    }
+
+    explicit CompressedPair(F& first) : FirstElement<F>(first) {
+    }
+
     F& GetFirst() {
         return FirstElement<F>::GetValue();
     }
@@ -504,3 +504,46 @@ TEST_CASE("Upcasts") {
         s2 = std::move(s);
     }
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Trace policy") {
+    using Trace = RingBufferTrace<8>;
+
+    SECTION("Disabled by default") {
+        static_assert(std::is_empty_v<NoTrace>);
+        static_assert(sizeof(UniquePtr<int, DefaultDeleter<int>, NoTrace>) == sizeof(void*));
+        static_assert(sizeof(UniquePtr<int, DefaultDeleter<int>, Trace>) == sizeof(void*));
+    }
+
+    SECTION("Lifetime events") {
+        Trace::Clear();
+        int* raw = new int(42);
+        {
+            UniquePtr<int, DefaultDeleter<int>, Trace> s(raw);
+            UniquePtr<int, DefaultDeleter<int>, Trace> s2(std::move(s));
+            s2 = nullptr;
+        }
+        std::vector<TraceEvent> events;
+        for (const TraceRecord& record : Trace::Snapshot()) {
+            events.push_back(record.event);
+        }
+        REQUIRE(events == std::vector<TraceEvent>{TraceEvent::kConstruct,
+                                                  TraceEvent::kMoveConstruct,
+                                                  TraceEvent::kReset, TraceEvent::kDelete,
+                                                  TraceEvent::kDestroy, TraceEvent::kDestroy});
+        REQUIRE(Trace::Snapshot()[3].object == raw);
+    }
+
+    SECTION("Ring buffer keeps the latest events") {
+        Trace::Clear();
+        for (int i = 0; i < 5; ++i) {
+            UniquePtr<MyInt[], DefaultDeleter<MyInt[]>, Trace> u(new MyInt[2]);
+        }
+        REQUIRE(Trace::Written() == 15);
+        auto records = Trace::Snapshot();
+        REQUIRE(records.size() == 8);
+        REQUIRE(records.back().event == TraceEvent::kDelete);
+        REQUIRE(MyInt::AliveCount() == 0);
+    }
+}
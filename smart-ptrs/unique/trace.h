@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Lifetime events reported by `UniquePtr` to its trace policy.
+enum class TraceEvent : uint8_t {
+    kConstruct,
+    kMoveConstruct,
+    kMoveAssign,
+    kReset,
+    kDelete,
+    kDestroy,
+};
+
+inline const char* ToString(TraceEvent event) {
+    switch (event) {
+        case TraceEvent::kConstruct:
+            return "construct";
+        case TraceEvent::kMoveConstruct:
+            return "move-construct";
+        case TraceEvent::kMoveAssign:
+            return "move-assign";
+        case TraceEvent::kReset:
+            return "reset";
+        case TraceEvent::kDelete:
+            return "delete";
+        case TraceEvent::kDestroy:
+            return "destroy";
+    }
+    return "unknown";
+}
+
+struct TraceRecord {
+    TraceEvent event;
+    const void* owner;
+    const void* object;
+};
+
+// Default policy: every call is an empty inline function, so tracing costs nothing.
+struct NoTrace {
+    static void Record(TraceEvent, const void*, const void*) noexcept {
+    }
+};
+
+// Writes events into a fixed-size ring buffer owned by the calling thread.
+// Recording never locks and never allocates; the oldest events are overwritten.
+template <size_t Capacity = 4096>
+class RingBufferTrace {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    static void Record(TraceEvent event, const void* owner, const void* object) noexcept {
+        Buffer& buffer = GetBuffer();
+        buffer.records[buffer.written & (Capacity - 1)] = TraceRecord{event, owner, object};
+        ++buffer.written;
+    }
+
+    // Events of the calling thread, oldest first.
+    static std::vector<TraceRecord> Snapshot() {
+        const Buffer& buffer = GetBuffer();
+        size_t begin = buffer.written > Capacity ? buffer.written - Capacity : 0;
+        std::vector<TraceRecord> result;
+        result.reserve(buffer.written - begin);
+        for (size_t i = begin; i < buffer.written; ++i) {
+            result.push_back(buffer.records[i & (Capacity - 1)]);
+        }
+        return result;
+    }
+
+    static void Dump(std::ostream& out) {
+        for (const TraceRecord& record : Snapshot()) {
+            out << ToString(record.event) << ' ' << record.owner << ' ' << record.object << '\n';
+        }
+    }
+
+    // Total number of events recorded by the calling thread, including overwritten ones.
+    static size_t Written() {
+        return GetBuffer().written;
+    }
+
+    static void Clear() {
+        GetBuffer().written = 0;
+    }
+
+private:
+    struct Buffer {
+        std::array<TraceRecord, Capacity> records;
+        size_t written = 0;
+    };
+
+    static Buffer& GetBuffer() {
+        thread_local Buffer buffer;
+        return buffer;
+    }
+};
@@ -2,10 +2,10 @@
 
 #include "compressed_pair.h"
 #include "deleters.h"
+#include "trace.h"
 
 #include <cstddef>  // std::nullptr_t
 #include <algorithm>
-#include <iostream>
 
 template <typename Object>
 class DefaultDeleter {
@@ -14,7 +14,6 @@ public:
     ~DefaultDeleter() = default;
 
     void operator()(Object* object) noexcept {
-        std::cout << "void operator()(Object* object) DefaultDeleter" << object << '\n';
         delete object;
     }
 
@@ -31,7 +30,6 @@ public:
     ~DefaultDeleter() = default;
 
     void operator()(Object* object) noexcept {
-        std::cout << "void operator()(Object* object) DefaultDeleter<Object[]>" << object << '\n';
         delete[] object;
     }
 
@@ -41,21 +39,22 @@ public:
 };
 
 // Primary template
-template <typename T, typename Deleter = DefaultDeleter<T>>
+// `Trace` receives every lifetime event; the default `NoTrace` compiles to nothing.
+template <typename T, typename Deleter = DefaultDeleter<T>, typename Trace = NoTrace>
 class UniquePtr {
 public:
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Constructors
-    template <typename U, typename D>
+    template <typename U, typename D, typename Tr>
     friend class UniquePtr;
 
     explicit UniquePtr(T* ptr = nullptr) noexcept {
-        std::cout << "explicit UniquePtr(T* ptr = nullptr) " << this << '\n';
+        Trace::Record(TraceEvent::kConstruct, this, ptr);
         object_block_.GetFirst() = ptr;
     }
 
     UniquePtr(T* ptr, Deleter deleter) noexcept {
-        std::cout << "UniquePtr(T* ptr, Deleter deleter) noexcept" << this << '\n';
+        Trace::Record(TraceEvent::kConstruct, this, ptr);
         object_block_.GetFirst() = ptr;
         object_block_.GetSecond() = std::forward<Deleter>(deleter);
     }
@@ -63,12 +62,13 @@ public:
     UniquePtr(const UniquePtr&) = delete;
 
     UniquePtr(UniquePtr&& other) noexcept {
-        std::cout << "UniquePtr(UniquePtr&& other) noexcept" << this << '\n';
+        Trace::Record(TraceEvent::kMoveConstruct, this, other.Get());
         object_block_.GetFirst() = std::forward<T*>(other.Release());
         object_block_.GetSecond() = std::forward<Deleter>(other.GetDeleter());
     }
     template <class Type, class CustomDeleter>
-    UniquePtr(UniquePtr<Type, CustomDeleter>&& other) noexcept {
+    UniquePtr(UniquePtr<Type, CustomDeleter, Trace>&& other) noexcept {
+        Trace::Record(TraceEvent::kMoveConstruct, this, other.Get());
         object_block_.GetFirst() = std::forward<Type*>(other.Release());
         object_block_.GetSecond() = std::forward<CustomDeleter>(other.GetDeleter());
     }
@@ -76,22 +76,23 @@ public:
     // `operator=`-s
 
     UniquePtr& operator=(std::nullptr_t) noexcept {
-        std::cout << "UniquePtr& operator=(std::nullptr_t)" << '\n';
+        Trace::Record(TraceEvent::kReset, this, nullptr);
         T* object_saved = object_block_.GetFirst();
         object_block_.GetFirst() = nullptr;
         if (object_saved) {
-            GetDeleter()(object_saved);
+            Delete(object_saved);
         }
         return *this;
     }
 
     template <class Type, class CustomDeleter>
-    UniquePtr& operator=(UniquePtr<Type, CustomDeleter>&& other) noexcept {
+    UniquePtr& operator=(UniquePtr<Type, CustomDeleter, Trace>&& other) noexcept {
         if (this->object_block_.GetFirst() == other.object_block_.GetFirst()) {
             return *this;
         }
+        Trace::Record(TraceEvent::kMoveAssign, this, other.Get());
         T* object_copy = this->object_block_.GetFirst();
-        GetDeleter()(object_copy);
+        Delete(object_copy);
         this->object_block_.GetFirst() = std::forward<Type*>(other.Release());
         this->object_block_.GetSecond() =
             std::forward<CustomDeleter>(other.object_block_.GetSecond());
@@ -104,9 +105,9 @@ public:
     // Destructor
 
     ~UniquePtr() {
-        std::cout << "~UniquePtr() " << this << '\n';
+        Trace::Record(TraceEvent::kDestroy, this, object_block_.GetFirst());
         if (object_block_.GetFirst() != nullptr) {
-            GetDeleter()(object_block_.GetFirst());
+            Delete(object_block_.GetFirst());
         }
     }
 
@@ -120,10 +121,11 @@ public:
     }
 
     void Reset(T* ptr = nullptr) {
+        Trace::Record(TraceEvent::kReset, this, ptr);
         T* object_saved = object_block_.GetFirst();
         object_block_.GetFirst() = ptr;
         if (object_saved != nullptr) {
-            GetDeleter()(object_saved);
+            Delete(object_saved);
         }
     };
 
@@ -165,16 +167,21 @@ public:
     }
 
 private:
+    void Delete(T* object) {
+        Trace::Record(TraceEvent::kDelete, this, object);
+        GetDeleter()(object);
+    }
+
     CompressedPair<T*, Deleter> object_block_;
 };
 
-template <typename T, typename Deleter>
-class UniquePtr<T[], Deleter> {
+template <typename T, typename Deleter, typename Trace>
+class UniquePtr<T[], Deleter, Trace> {
 public:
-    template <typename U, typename D>
+    template <typename U, typename D, typename Tr>
     friend class UniquePtr;
     explicit UniquePtr(T* ptr = nullptr) noexcept {
-        std::cout << "explicit UniquePtr(T* ptr = nullptr) " << this << '\n';
+        Trace::Record(TraceEvent::kConstruct, this, ptr);
         object_block_.GetFirst() = ptr;
     }
 
@@ -183,19 +190,21 @@ public:
     }
 
     void Reset(std::nullptr_t = nullptr) noexcept {
+        Trace::Record(TraceEvent::kReset, this, nullptr);
         T* object_saved = object_block_.GetFirst();
         object_block_.GetFirst() = nullptr;
         if (object_saved != nullptr) {
-            GetDeleter()(object_saved);
+            Delete(object_saved);
         }
     }
 
     template <class S>
     void Reset(S* ptr) noexcept {
+        Trace::Record(TraceEvent::kReset, this, ptr);
         T* object_saved = object_block_.GetFirst();
         object_block_.GetFirst() = ptr;
         if (object_saved != nullptr) {
-            GetDeleter()(object_saved);
+            Delete(object_saved);
         }
     };
 
@@ -207,11 +216,17 @@ public:
     }
 
     ~UniquePtr() {
+        Trace::Record(TraceEvent::kDestroy, this, object_block_.GetFirst());
         if (object_block_.GetFirst() != nullptr) {
-            GetDeleter()(object_block_.GetFirst());
+            Delete(object_block_.GetFirst());
         }
     }
 
 private:
+    void Delete(T* object) {
+        Trace::Record(TraceEvent::kDelete, this, object);
+        GetDeleter()(object);
+    }
+
     CompressedPair<T*, Deleter> object_block_;
 };